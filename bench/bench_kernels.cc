@@ -0,0 +1,320 @@
+// Micro-benchmark of the registered CPU kernels over a sweep of shapes and
+// data types. Every kernel registered for an op type is measured, variants
+// included. Build and run it with `make bench`, or
+// `cmake --build <dir> --target bench && <dir>/bench [options]`:
+//   --filter <text>   only op types whose name contains <text>
+//   --min-time <s>    measuring time per case, 0.2 by default
+//   --threads <n>     threads of the runtime pool, 1 by default
+//   --json <file>     also write the results as JSON
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include "utils/data_generator.h"
+#include "utils/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+namespace infini
+{
+    struct BenchCase
+    {
+        OpType opType;
+        DataType dtype;
+        // adds the op to the graph
+        std::function<Operator(const Graph &)> build;
+    };
+
+    struct BenchResult
+    {
+        string op, kernel, dtype, shapes;
+        size_t iterations;
+        // per call
+        double seconds, gflops, gbps;
+    };
+
+    template <typename T>
+    static void addBinary(vector<BenchCase> &cases, OpType opType,
+                          DataType dtype, Shape a, Shape b)
+    {
+        cases.push_back({opType, dtype, [=](const Graph &g)
+                         {
+                             auto x = g->addTensor(a, dtype);
+                             auto y = g->addTensor(b, dtype);
+                             return Operator(g->addOp<T>(x, y, nullptr));
+                         }});
+    }
+
+    static vector<BenchCase> benchCases()
+    {
+        vector<BenchCase> cases;
+        const vector<Shape> sizes{{1, 1024}, {256, 1024}, {1024, 1024}};
+        for (auto dtype : {DataType::Float32, DataType::UInt32})
+        {
+            for (auto &shape : sizes)
+            {
+                addBinary<AddObj>(cases, OpType::Add, dtype, shape, shape);
+                addBinary<SubObj>(cases, OpType::Sub, dtype, shape, shape);
+                addBinary<MulObj>(cases, OpType::Mul, dtype, shape, shape);
+                addBinary<DivObj>(cases, OpType::Div, dtype, shape, shape);
+                // row broadcast
+                addBinary<AddObj>(cases, OpType::Add, dtype, shape,
+                                  {1, shape[1]});
+                cases.push_back({OpType::Relu, dtype, [=](const Graph &g)
+                                 {
+                                     auto x = g->addTensor(shape, dtype);
+                                     return Operator(
+                                         g->addOp<ReluObj>(x, nullptr));
+                                 }});
+                cases.push_back({OpType::Clip, dtype, [=](const Graph &g)
+                                 {
+                                     auto x = g->addTensor(shape, dtype);
+                                     return Operator(g->addOp<ClipObj>(
+                                         x, nullptr, 1.0f, 100.0f));
+                                 }});
+            }
+            for (auto &[shape, permute] :
+                 vector<std::pair<Shape, vector<int>>>{
+                     {{1024, 1024}, {1, 0}},
+                     {{32, 64, 128}, {0, 2, 1}},
+                     {{16, 32, 64, 8}, {0, 3, 1, 2}}})
+                cases.push_back({OpType::Transpose, dtype,
+                                 [=, shape = shape, permute = permute](
+                                     const Graph &g)
+                                 {
+                                     auto x = g->addTensor(shape, dtype);
+                                     return Operator(g->addOp<TransposeObj>(
+                                         x, nullptr, permute));
+                                 }});
+            for (auto &[shape, count, dim] :
+                 vector<std::tuple<Shape, int, int>>{{{512, 1024}, 2, 0},
+                                                     {{1024, 512}, 2, 1},
+                                                     {{256, 256, 4}, 4, 2}})
+                cases.push_back({OpType::Concat, dtype,
+                                 [=, shape = shape, count = count,
+                                  dim = dim](const Graph &g)
+                                 {
+                                     TensorVec inputs;
+                                     for (int i = 0; i < count; ++i)
+                                         inputs.push_back(
+                                             g->addTensor(shape, dtype));
+                                     return Operator(g->addOp<ConcatObj>(
+                                         inputs, nullptr, dim));
+                                 }});
+        }
+        for (auto &[a, b] : vector<std::pair<Shape, Shape>>{
+                 {{128, 128}, {128, 128}},
+                 {{512, 512}, {512, 512}},
+                 {{8, 128, 64}, {8, 64, 128}}})
+            cases.push_back({OpType::MatMul, DataType::Float32,
+                             [a = a, b = b](const Graph &g)
+                             {
+                                 auto x = g->addTensor(a, DataType::Float32);
+                                 auto y = g->addTensor(b, DataType::Float32);
+                                 return Operator(
+                                     g->addOp<MatmulObj>(x, y, nullptr));
+                             }});
+        cases.push_back({OpType::Cast, DataType::Float32, [](const Graph &g)
+                         {
+                             auto x = g->addTensor({1024, 1024},
+                                                   DataType::Float32);
+                             return Operator(g->addOp<CastObj>(
+                                 x, nullptr, CastType::Float2Int32));
+                         }});
+        return cases;
+    }
+
+    // arithmetic operations of one call of the op
+    static double flopsOf(const Operator &op)
+    {
+        auto output = op->getOutput();
+        switch (op->getOpType().underlying())
+        {
+        case OpType::Add:
+        case OpType::Sub:
+        case OpType::Mul:
+        case OpType::Div:
+        case OpType::Relu:
+        case OpType::Clip:
+            return output->size();
+        case OpType::MatMul:
+        {
+            auto matmul = as<MatmulObj>(op);
+            auto dims = op->getInputs(0)->getDims();
+            auto k = matmul->getTransA() ? dims[dims.size() - 2]
+                                         : dims[dims.size() - 1];
+            return 2.0 * output->size() * k;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    static string shapesOf(const Operator &op)
+    {
+        string ret;
+        for (auto &input : op->getInputs())
+            ret += (ret.empty() ? "" : " ") + vecToString(input->getDims());
+        return ret + " -> " + vecToString(op->getOutput()->getDims());
+    }
+
+    // seconds per call of `launch`, measured over batches of calls
+    static std::pair<double, size_t>
+    measure(const std::function<void()> &launch, double minTime)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto elapsed = [](Clock::time_point begin)
+        {
+            return std::chrono::duration<double>(Clock::now() - begin).count();
+        };
+        // warm up, and size the batches to about 1 ms
+        auto begin = Clock::now();
+        launch();
+        size_t batch = std::max<size_t>(1, size_t(1e-3 / std::max(elapsed(begin), 1e-9)));
+
+        double best = std::numeric_limits<double>::max();
+        size_t iterations = 0;
+        auto start = Clock::now();
+        do
+        {
+            begin = Clock::now();
+            for (size_t i = 0; i < batch; ++i)
+                launch();
+            best = std::min(best, elapsed(begin) / batch);
+            iterations += batch;
+        } while (elapsed(start) < minTime);
+        return {best, iterations};
+    }
+
+    static vector<BenchResult> runBench(const string &filter, double minTime,
+                                        size_t threads)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setNumThreads(threads);
+        const auto &registry = KernelRegistry::getInstance();
+
+        vector<BenchResult> results;
+        for (auto &benchCase : benchCases())
+        {
+            string opName = benchCase.opType.toString();
+            if (opName.find(filter) == string::npos)
+                continue;
+            try
+            {
+                Graph g = make_ref<GraphObj>(runtime);
+                auto op = benchCase.build(g);
+                // shape inference left unimplemented yields scalar outputs
+                for (auto &output : op->getOutputs())
+                    IT_ASSERT(output->getRank() > 0,
+                              "no shape inferred for " + op->toString());
+                g->dataMalloc();
+                for (auto &input : op->getInputs())
+                    input->setData(OneGenerator());
+
+                double bytes = 0;
+                for (auto &input : op->getInputs())
+                    bytes += input->getBytes();
+                bytes += op->getOutput()->getBytes();
+                double flops = flopsOf(op);
+
+                for (auto &record : registry.getKernelItems(
+                         KernelAttrs{Device::CPU, benchCase.opType.underlying()}))
+                {
+                    auto launch = std::get<0>(record)->prepare(op, runtime.get());
+                    auto [seconds, iterations] = measure(launch, minTime);
+                    results.push_back({opName, std::get<1>(record),
+                                       benchCase.dtype.toString(), shapesOf(op),
+                                       iterations, seconds,
+                                       flops / seconds * 1e-9,
+                                       bytes / seconds * 1e-9});
+                    auto &r = results.back();
+                    std::cout << std::left << std::setw(10) << r.op
+                              << std::setw(22) << r.kernel << std::setw(9)
+                              << r.dtype << std::setw(44) << r.shapes
+                              << std::right << std::fixed
+                              << std::setprecision(2) << std::setw(12)
+                              << r.seconds * 1e6 << " us" << std::setw(10)
+                              << r.gflops << " GFLOP/s" << std::setw(10)
+                              << r.gbps << " GB/s" << std::endl;
+                }
+            }
+            catch (const std::runtime_error &e)
+            {
+                std::cout << std::left << std::setw(10) << opName
+                          << std::setw(22) << "skipped" << std::setw(9)
+                          << benchCase.dtype.toString()
+                          << e.runtime_error::what()
+                          << std::endl;
+            }
+        }
+        return results;
+    }
+
+    static string toJson(const vector<BenchResult> &results)
+    {
+        std::ostringstream os;
+        os << "[";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto &r = results[i];
+            os << (i ? ",\n " : "\n ") << "{\"op\": \"" << r.op
+               << "\", \"kernel\": \"" << r.kernel << "\", \"dtype\": \""
+               << r.dtype << "\", \"shapes\": \"" << r.shapes
+               << "\", \"iterations\": " << r.iterations
+               << ", \"time_us\": " << r.seconds * 1e6
+               << ", \"gflops\": " << r.gflops << ", \"gbps\": " << r.gbps
+               << "}";
+        }
+        os << "\n]\n";
+        return os.str();
+    }
+
+} // namespace infini
+
+int main(int argc, char **argv)
+{
+    using namespace infini;
+    string filter, json;
+    double minTime = 0.2;
+    size_t threads = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto arg = string(argv[i]);
+        auto value = [&]
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value of " << arg << std::endl;
+                std::exit(1);
+            }
+            return string(argv[++i]);
+        };
+        if (arg == "--filter")
+            filter = value();
+        else if (arg == "--min-time")
+            minTime = std::stod(value());
+        else if (arg == "--threads")
+            threads = std::stoul(value());
+        else if (arg == "--json")
+            json = value();
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // stdout holds only the result rows
+    setLogLevel(LogLevel::Quiet);
+    auto results = runBench(filter, minTime, threads);
+    if (!json.empty())
+        std::ofstream(json) << toJson(results);
+    return 0;
+}
@@ -6,6 +6,7 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <set>
 #include <unordered_set>
 
 namespace infini {
@@ -20,13 +21,25 @@ namespace infini {
 
     size_t alignment;
 
+    // bytes added by rounding the allocated blocks up to the alignment
+    size_t padding;
+
     // pointer to the memory actually allocated
     void *ptr;
 
-    // =================================== 作业 ===================================
-    // TODO：可能需要设计一个数据结构来存储free block，以便于管理和合并
-    // HINT: 可以使用一个 map 来存储 free block，key 为 block 的起始/结尾地址，value 为 block 的大小
-    // =================================== 作业 ===================================
+    // pointer returned by the runtime, ptr rounded up to the alignment if the
+    // runtime does not guarantee it
+    void *rawPtr;
+
+    // size of the memory at rawPtr
+    size_t capacity;
+
+    // free blocks indexed by head address offset, value is the block size;
+    // neighbours are looked up here to merge adjacent blocks on free
+    std::map<size_t, size_t> freeBlocks;
+
+    // the same free blocks ordered by (size, offset) for best-fit lookup
+    std::set<std::pair<size_t, size_t>> freeBlocksBySize;
 
   public:
     Allocator(Runtime runtime);
@@ -49,11 +62,46 @@ namespace infini {
     // return: pointer to the head address of the allocated memory
     void *getPtr();
 
+    // function: forget all simulated allocations to plan again, the memory
+    // actually allocated is kept and reused by getPtr() if it is large enough
+    void reset();
+
+    // function: make the memory returned by getPtr() at least `size` bytes
+    void reserve(size_t size);
+
     void info();
 
+    // function: external fragmentation of the simulated memory
+    // return: 1 - (largest free block / total free bytes), 0 if nothing is free
+    double getFragmentation() const;
+
+    size_t getUsed() const { return used; }
+
+    size_t getPeak() const { return peak; }
+
+    size_t getAlignment() const { return alignment; }
+
+    // function: set the alignment of the head address of every block, must
+    // be called before any allocation
+    // arguments:
+    //     alignment: a power of two
+    void setAlignment(size_t alignment);
+
+    size_t getPadding() const { return padding; }
+
+    // function: count the padding of blocks aligned by the caller, e.g. a
+    // memory plan reserved as a whole
+    // arguments:
+    //     bytes: bytes added by the alignment
+    void addPadding(size_t bytes) { padding += bytes; }
+
   private:
     // function: memory alignment, rouned up
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+    void insertFreeBlock(size_t addr, size_t size);
+
+    void eraseFreeBlock(std::map<size_t, size_t>::iterator it);
   };
 }
@@ -0,0 +1,62 @@
+#pragma once
+#include "core/graph.h"
+#include "core/runtime.h"
+
+namespace infini
+{
+    /**
+     * @brief An immutable capture of a planned graph made of plain structs and
+     * raw data pointers, whose kernels are resolved once. Replaying it touches
+     * no Ref and, when the runtime has no thread pool, allocates nothing
+     * (save element-wise broadcasts left at a rank above 8 once merged).
+     *
+     * The capture keeps the graph alive but is not updated with it: it must be
+     * frozen again after the graph is changed or planned again.
+     */
+    class FrozenGraph
+    {
+    public:
+        struct TensorInfo
+        {
+            UidBaseType fuid;
+            DataType dtype;
+            Shape dims;
+            size_t bytes;
+            void *data;
+        };
+
+        struct OpInfo
+        {
+            UidBaseType guid;
+            OpType opType;
+            string kernel;
+            // indices in the tensors of the capture
+            vector<size_t> inputs, outputs;
+        };
+
+    private:
+        // owns the memory of the tensors, never used by the replay
+        Graph graph;
+        vector<TensorInfo> tensors;
+        vector<OpInfo> ops;
+        vector<std::function<void()>> launches;
+        // indices of the non-constant graph inputs and of the graph outputs
+        vector<size_t> inputs, outputs;
+
+    public:
+        explicit FrozenGraph(const Graph &graph);
+        FrozenGraph(const FrozenGraph &) = delete;
+        FrozenGraph &operator=(const FrozenGraph &) = delete;
+
+        /**
+         * @brief Runs the operators one by one in topological order.
+         */
+        void run() const;
+
+        const vector<TensorInfo> &getTensors() const { return tensors; }
+        const vector<OpInfo> &getOperators() const { return ops; }
+        const vector<size_t> &getInputs() const { return inputs; }
+        const vector<size_t> &getOutputs() const { return outputs; }
+    };
+
+} // namespace infini
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/allocator.h"
+#include "core/memory_planner.h"
 #include "core/operator.h"
 #include "core/tensor.h"
 #include <algorithm>
@@ -14,11 +15,22 @@ namespace infini
         Runtime runtime;
         TensorVec tensors;
         OpVec ops;
+        // activations, planned again by every call to dataMalloc
         Allocator allocator;
+        // constant tensors, allocated once
+        Allocator weightAllocator;
+        // keeps the graph owning a shared activation memory alive
+        Ref<GraphObj> arenaOwner;
+        // activation plan of the last dataMalloc
+        MemoryPlan activationPlan;
+        // activation plans computed by dataMalloc
+        std::unordered_map<MemoryPlanKey, MemoryPlan, MemoryPlanKeyHash>
+            planCache;
 
     public:
         explicit GraphObj(Runtime runtime)
-            : runtime(runtime), allocator(runtime), sorted(false){};
+            : runtime(runtime), allocator(runtime), weightAllocator(runtime),
+              sorted(false){};
         string toString() const override;
         Runtime getRuntime() const { return runtime; }
 
@@ -55,7 +67,77 @@ namespace infini
 
         void shape_infer();
 
-        void dataMalloc();
+        /**
+         * @brief Changes the shapes of non-constant graph inputs and infers
+         * the shapes of the operators depending on them only. If every
+         * tensor still fits in its memory and no output of an in-place safe
+         * operator differs in shape from its inputs, the current plan is
+         * kept; otherwise the activations are planned again by dataMalloc with
+         * `strategy`, which reuses cached plans and the current memory when
+         * it is large enough. Returns true if the activations were planned
+         * again. Either way, kernels compiled for the graph must be compiled
+         * again.
+         */
+        bool setInputShapes(
+            const vector<std::pair<Tensor, Shape>> &shapes,
+            MemoryPlanStrategy strategy = MemoryPlanStrategy::Sequential);
+
+        /**
+         * @brief Sets the alignment of every tensor of this graph, overriding
+         * the default of the runtime. Must be called before dataMalloc.
+         */
+        void setAlignment(size_t alignment) { allocator.setAlignment(alignment); }
+        size_t getAlignment() const { return allocator.getAlignment(); }
+
+        /**
+         * @brief Allocates the constant tensors once in a persistent region,
+         * then plans the memory of the other tensors with the given strategy
+         * and binds them to a single activation memory. Calling it again
+         * plans the activations again and reuses their memory if it is large
+         * enough, the constant tensors keep their memory and data.
+         */
+        void dataMalloc(
+            MemoryPlanStrategy strategy = MemoryPlanStrategy::Sequential);
+
+        /**
+         * @brief dataMalloc for several graphs whose activations share one
+         * memory, sized for the largest plan. Each graph keeps its own
+         * constant tensors. The graphs must have the same alignment, must
+         * not run at the same time, and must be planned again together,
+         * since a larger plan may move the shared memory.
+         */
+        static void dataMalloc(
+            const vector<Ref<GraphObj>> &graphs,
+            MemoryPlanStrategy strategy = MemoryPlanStrategy::Sequential);
+
+        /**
+         * @brief Gets the activation plan bound by the last dataMalloc, with
+         * the offset, size and lifetime of every planned tensor and the
+         * memory usage while each operator runs.
+         */
+        const MemoryPlan &getMemoryPlan() const { return activationPlan; }
+
+        /**
+         * @brief Binds the activations to `ptr` with the plan of the last
+         * dataMalloc. `ptr` must hold getMemoryPlan().peak bytes aligned to
+         * getAlignment(), and outlive the binding. A null `ptr` binds them
+         * back to the memory allocated by dataMalloc.
+         */
+        void bindActivations(void *ptr);
+
+        /**
+         * @brief Number of activation plans cached by dataMalloc. A plan is
+         * reused when the sorted operators, the tensor shapes and data types,
+         * the strategy and the alignment are the same.
+         */
+        size_t getPlanCacheSize() const { return planCache.size(); }
+        void clearPlanCache() { planCache.clear(); }
+
+        /**
+         * @brief Runs every memory planning strategy on this graph without
+         * allocating memory. Returns the peak memory of each strategy.
+         */
+        std::map<MemoryPlanStrategy, size_t> compareMemoryPlans();
 
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
@@ -107,6 +189,29 @@ namespace infini
         bool checkValid() const;
 
     private:
+        /**
+         * @brief Allocates and binds the constant tensors not allocated yet.
+         */
+        void weightMalloc();
+
+        /**
+         * @brief Gets the tensors planned in the activation memory.
+         */
+        TensorVec getActivations() const;
+
+        /**
+         * @brief Gets the key of the activation plans of this graph.
+         */
+        MemoryPlanKey getPlanKey(MemoryPlanStrategy strategy) const;
+
+        /**
+         * @brief Plans the activations on a reset allocator, or takes the plan
+         * from the cache.
+         */
+        MemoryPlan planActivations(MemoryPlanStrategy strategy);
+
+        void bindActivations(const MemoryPlan &plan, void *ptr);
+
         /**
          * @brief Add reverse connections and Op relationship in ctor.
          */
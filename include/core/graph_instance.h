@@ -0,0 +1,49 @@
+#pragma once
+#include "core/allocator.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+
+namespace infini
+{
+    /**
+     * @brief A planned graph compiled on its own activation memory. Instances
+     * of one graph share its constant tensors and can run at the same time,
+     * e.g. with NativeCpuRuntimeObj::runAsync.
+     *
+     * Creating an instance binds the activations of the graph for a moment,
+     * so it must not happen while the graph runs or is planned again. The
+     * instance stays valid as long as the graph is neither changed nor
+     * planned again.
+     */
+    class GraphInstance
+    {
+    private:
+        Graph graph;
+        Allocator memory;
+        ExecutionPlan plan;
+        // data of every tensor in this instance, keyed by fuid
+        std::unordered_map<UidBaseType, void *> data;
+
+    public:
+        explicit GraphInstance(const Graph &graph);
+        GraphInstance(const GraphInstance &) = delete;
+        GraphInstance &operator=(const GraphInstance &) = delete;
+
+        const Graph &getGraph() const { return graph; }
+        const ExecutionPlan &getPlan() const { return plan; }
+
+        /**
+         * @brief Gets the data of a tensor of the graph in this instance.
+         */
+        template <typename T>
+        T getRawDataPtr(const Tensor &tensor) const
+        {
+            static_assert(std::is_pointer_v<T>,
+                          "Raw data pointer has a type of pointer");
+            auto it = data.find(tensor->getFuid());
+            IT_ASSERT(it != data.end(), "Tensor not in the graph");
+            return static_cast<T>(it->second);
+        }
+    };
+
+} // namespace infini
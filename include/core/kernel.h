@@ -3,6 +3,7 @@
 #include "core/operator.h"
 #include "core/tensor.h"
 #include "utils/operator_utils.h"
+#include <algorithm>
 #include <functional>
 
 namespace infini
@@ -21,50 +22,108 @@ namespace infini
          */
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+        /**
+         * @brief Resolves the data pointers and parameters of an op once. The
+         * returned launch computes the op without looking at it again, as long
+         * as its tensors keep their data. By default it calls compute.
+         */
+        virtual std::function<void()> prepare(const Operator &op,
+                                              const RuntimeObj *context) const
+        {
+            return [this, op, context]
+            { compute(op, context); };
+        }
     };
 
     class KernelRegistry
     {
     public:
         using KernelRecord =
-            tuple<Kernel *const, const string, const int>; // Kernel, name, ID
+            tuple<Kernel *const, const string, const int,
+                  const bool>; // Kernel, name, ID, in-place safe
 
     private:
-        std::map<KernelAttrs, KernelRecord> kernels;
+        // the kernels of every key, the default one first
+        std::map<KernelAttrs, vector<KernelRecord>> kernels;
+        // keys whose default kernel is registered
+        std::set<KernelAttrs> defaults;
         int nKernels = 0;
 
     public:
         ~KernelRegistry()
         {
-            for (auto &[k, v] : kernels)
-                delete std::get<0>(v);
+            for (auto &[k, records] : kernels)
+                for (auto &v : records)
+                    delete std::get<0>(v);
         }
         static KernelRegistry &getInstance()
         {
             static KernelRegistry instance;
             return instance;
         }
-        bool registerKernel(const KernelAttrs &key, Kernel *kernel, string name)
+        /**
+         * @brief Registers a kernel. `inPlace` marks that the kernel stays
+         * correct when its output shares memory with an input of the same
+         * shape, which lets the memory planner reuse the input for the output.
+         * A key has one default kernel and any number of variants, which are
+         * only used when kernel tuning is enabled on the runtime.
+         */
+        bool registerKernel(const KernelAttrs &key, Kernel *kernel, string name,
+                            bool inPlace = false, bool variant = false)
         {
-            IT_ASSERT(kernels.find(key) == kernels.end(),
-                      "Kernel already registered");
-            kernels.emplace(key, KernelRecord{kernel, name, ++nKernels});
+            auto &records = kernels[key];
+            for (auto &record : records)
+                IT_ASSERT(std::get<1>(record) != name,
+                          "Kernel already registered");
+            KernelRecord record{kernel, name, ++nKernels, inPlace};
+            if (variant)
+            {
+                records.emplace_back(record);
+                return true;
+            }
+            IT_ASSERT(defaults.insert(key).second,
+                      "Default kernel already registered");
+            // records are not assignable, so the default is put first by
+            // copying
+            vector<KernelRecord> sorted{record};
+            for (auto &variantRecord : records)
+                sorted.emplace_back(variantRecord);
+            records.swap(sorted);
             return true;
         }
         Kernel *getKernel(const KernelAttrs &kernelAttrs) const
+        {
+            return std::get<0>(getKernelItem(kernelAttrs));
+        }
+        // an in-place output is only safe if every kernel of the key is
+        bool isInPlaceSafe(const KernelAttrs &kernelAttrs) const
         {
             auto it = kernels.find(kernelAttrs);
-            IT_ASSERT(it != kernels.end(), "Kernel not found for key {" +
-                                               get_kernel_attrs_str(kernelAttrs) +
-                                               "}");
-            return std::get<0>(it->second);
+            return it != kernels.end() &&
+                   std::all_of(it->second.begin(), it->second.end(),
+                               [](const KernelRecord &record)
+                               { return std::get<3>(record); });
         }
         const KernelRecord &getKernelItem(const KernelAttrs &kernelAttrs) const
         {
-            return kernels.at(kernelAttrs);
+            return getKernelItems(kernelAttrs).front();
+        }
+        const vector<KernelRecord> &
+        getKernelItems(const KernelAttrs &kernelAttrs) const
+        {
+            auto it = kernels.find(kernelAttrs);
+            IT_ASSERT(it != kernels.end(), "Kernel not found for key {" +
+                                               get_kernel_attrs_str(kernelAttrs) +
+                                               "}");
+            return it->second;
         }
     };
 
+    // fewest iterations of a simple loop over elements worth a chunk of
+    // RuntimeObj::parallelFor
+    constexpr size_t elementGrain = 1 << 14;
+
     class CpuKernelWithoutConfig : public Kernel
     {
     public:
@@ -74,14 +133,25 @@ namespace infini
 
 } // namespace infini
 
-#define _REGISTER_KERNEL_1(device, opType, kernel, name, cnt)                 \
+#define _REGISTER_KERNEL_1(device, opType, kernel, name, inPlace, variant,  \
+                           cnt)                                               \
     namespace infini                                                          \
     {                                                                         \
         static const bool _CAT(_register_kernel_, cnt) =                      \
-            KernelRegistry::getInstance().registerKernel(KernelAttrs{device,  \
-                                                                     opType}, \
-                                                         new kernel(), name); \
+            KernelRegistry::getInstance().registerKernel(                     \
+                KernelAttrs{device, opType}, new kernel(), name, inPlace,     \
+                variant);                                                     \
     }
 
 #define REGISTER_KERNEL(device, opType, kernel, name) \
-    _REGISTER_KERNEL_1(device, opType, kernel, name, __COUNTER__)
+    _REGISTER_KERNEL_1(device, opType, kernel, name, false, false, __COUNTER__)
+
+#define REGISTER_INPLACE_KERNEL(device, opType, kernel, name) \
+    _REGISTER_KERNEL_1(device, opType, kernel, name, true, false, __COUNTER__)
+
+// variants are only used when kernel tuning is enabled
+#define REGISTER_KERNEL_VARIANT(device, opType, kernel, name) \
+    _REGISTER_KERNEL_1(device, opType, kernel, name, false, true, __COUNTER__)
+
+#define REGISTER_INPLACE_KERNEL_VARIANT(device, opType, kernel, name) \
+    _REGISTER_KERNEL_1(device, opType, kernel, name, true, true, __COUNTER__)
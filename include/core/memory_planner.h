@@ -0,0 +1,183 @@
+#pragma once
+#include "core/allocator.h"
+#include "core/operator.h"
+#include "core/tensor.h"
+
+namespace infini
+{
+    enum class MemoryPlanStrategy
+    {
+        // alloc/free in topological order on the graph allocator
+        Sequential = 0,
+        // largest tensors are placed first into the lifetime intervals
+        GreedyBySize,
+        // operators with the largest live set are served first
+        GreedyByBreadth,
+        // tensors are placed by start time at the lowest offset that fits
+        IntervalColoring,
+    };
+
+    string toString(MemoryPlanStrategy strategy);
+
+    struct MemoryPlan
+    {
+        struct TensorRecord
+        {
+            UidBaseType fuid;
+            size_t offset, bytes;
+            // indices of the first and the last operator using the tensor
+            size_t first, last;
+        };
+
+        struct TimelinePoint
+        {
+            // bytes of the memory alive while the operator runs
+            size_t live;
+            // end of the highest memory block alive
+            size_t footprint;
+            // share of the footprint not alive, 1 - live / footprint
+            double fragmentation;
+        };
+
+        // head address offset of every tensor, keyed by fuid
+        std::unordered_map<UidBaseType, size_t> offsets;
+        // size of the memory the plan needs
+        size_t peak = 0;
+        // bytes added by rounding the memory of every lifetime up to the
+        // alignment, whatever the strategy
+        size_t padding = 0;
+        // every planned tensor, in the order of the graph tensors
+        vector<TensorRecord> tensors;
+        // memory usage while each operator runs, indexed by operator
+        vector<TimelinePoint> timeline;
+
+        // header: fuid,offset,bytes,first,last
+        string tensorsToCsv() const;
+        // header: op,live,footprint,fragmentation
+        string timelineToCsv() const;
+        // {"peak": ..., "tensors": [...], "timeline": [...]}
+        string toJson() const;
+    };
+
+    // Structure, shapes and planning options of a graph, MemoryPlans computed
+    // for equal keys are interchangeable
+    using MemoryPlanKey = vector<int64_t>;
+
+    struct MemoryPlanKeyHash
+    {
+        size_t operator()(const MemoryPlanKey &key) const
+        {
+            // FNV-1a over the elements
+            size_t hash = 14695981039346656037ull;
+            for (auto v : key)
+            {
+                hash ^= std::hash<int64_t>()(v);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+
+    /**
+     * @brief Computes the offsets of the tensors of a topologically sorted
+     * graph. A tensor lives from the operator producing it (or the beginning
+     * for graph inputs) to its last consumer (or the end for graph outputs),
+     * and two tensors may share memory only if their lifetimes are disjoint.
+     *
+     * The output of an operator whose kernel is registered as in-place safe
+     * shares the memory of an input of the same shape and size that dies at
+     * this operator. The inputs of a Concat on its outermost non-unit
+     * dimension are placed as slices of its output, so the kernel has nothing
+     * to copy, unless a slice would not start on the alignment. Tensors sharing memory form one lifetime, which is what the
+     * strategies place.
+     *
+     * Only `tensors` are planned, operator inputs outside of it (e.g.
+     * constant weights) are ignored.
+     */
+    class MemoryPlanner
+    {
+    private:
+        struct TensorLifetime
+        {
+            struct Member
+            {
+                Tensor tensor;
+                // offset of the tensor in the memory
+                size_t offset;
+                // indices of the first and the last operator using the tensor
+                size_t first, last;
+            };
+            // tensors sharing the memory
+            vector<Member> tensors;
+            // aligned size in bytes
+            size_t size;
+            // indices of the first and the last operator using the memory
+            size_t first, last;
+            // bytes of the tensor the memory was created for, at offset 0
+            size_t headBytes;
+            // whether a member is a graph output, which keeps it to the end
+            bool holdsGraphOutput;
+        };
+
+        const OpVec &ops;
+        const TensorVec &tensors;
+        // alignment of the head address of every tensor
+        size_t alignment;
+        vector<TensorLifetime> lifetimes;
+        // index of the lifetime of every tensor
+        std::unordered_map<TensorObj *, size_t> lifetimeOf;
+        // offset of every tensor in the memory of its lifetime
+        std::unordered_map<TensorObj *, size_t> offsetInLifetime;
+
+    public:
+        MemoryPlanner(const OpVec &sortedOps, const TensorVec &tensors,
+                      size_t alignment);
+
+        /**
+         * @brief Plans with the given strategy. The sequential strategy runs on
+         * `allocator` directly, the others reserve the whole planned memory as
+         * a single block of `allocator`. Either way the padding of the plan is
+         * added to `allocator`.
+         */
+        MemoryPlan plan(MemoryPlanStrategy strategy, Allocator &allocator) const;
+
+        /**
+         * @brief The largest total size of tensors alive at the same time, no
+         * plan can use less memory than this.
+         */
+        size_t getLowerBound() const;
+
+    private:
+        // Merges the output of the idx-th operator into the lifetime of one of
+        // its inputs if its kernel can run in place. Returns false if no input
+        // can be reused.
+        bool tryInPlace(size_t idx,
+                        const std::unordered_map<TensorObj *, size_t> &lastUse);
+
+        // Merges the inputs of the idx-th operator, a Concat, into the
+        // lifetime of its output as slices of it where possible.
+        void tryZeroCopyConcat(size_t idx);
+
+        // Moves the tensors of lifetimes[from] into lifetimes[to], starting at
+        // `offset`. lifetimes[from] is left empty.
+        void mergeLifetime(size_t from, size_t to, size_t offset);
+
+        // Sets the offset of all tensors sharing lifetimes[idx].
+        void setOffset(MemoryPlan &plan, size_t idx, size_t offset) const;
+
+        // Fills the tensor records and the timeline of a plan with offsets.
+        void record(MemoryPlan &plan) const;
+
+        MemoryPlan planSequential(Allocator &allocator) const;
+        MemoryPlan planGreedyBySize() const;
+        MemoryPlan planGreedyByBreadth() const;
+        MemoryPlan planIntervalColoring() const;
+
+        // Places lifetimes[idx] among the already placed lifetimes overlapping
+        // with it, in the smallest gap that fits (best fit) or the lowest one
+        // (first fit). `placed` holds the indices of placed lifetimes.
+        size_t place(size_t idx, const vector<size_t> &placed,
+                     const vector<size_t> &offsets, bool bestFit) const;
+    };
+
+} // namespace infini
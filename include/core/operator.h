@@ -55,6 +55,13 @@ namespace infini
         virtual int numInputs() const = 0;
         virtual int numOutputs() const = 0;
 
+        /**
+         * @brief The attributes of the operator other than its tensors.
+         * Operators of one type with equal attributes and tensor shapes
+         * compute the same function.
+         */
+        virtual vector<int64_t> getOpAttrVector() const { return {}; }
+
         /**
          * @brief Clone this operator and replace its inputs and outputs.
          *
@@ -0,0 +1,65 @@
+#pragma once
+#include "core/op_type.h"
+#include "core/tensor.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace infini
+{
+    /**
+     * @brief Collects the time of every kernel call of the runs made while
+     * profiling is enabled on a runtime, see
+     * NativeCpuRuntimeObj::setProfiling.
+     */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Record
+        {
+            UidBaseType guid;
+            OpType opType;
+            vector<Shape> inputs, outputs;
+            string kernel;
+            // microseconds since the profiler was created
+            double begin, duration;
+            std::thread::id thread;
+        };
+
+        struct Stat
+        {
+            size_t calls = 0;
+            // microseconds
+            double total = 0, min = 0, max = 0;
+        };
+
+    private:
+        Clock::time_point epoch = Clock::now();
+        vector<Record> records;
+        std::mutex mutex;
+
+    public:
+        void add(Record record);
+        // microseconds since the profiler was created
+        double now() const;
+        void clear();
+
+        vector<Record> getRecords();
+        // statistics keyed by op type name
+        std::map<string, Stat> byOpType();
+        // statistics keyed by kernel name
+        std::map<string, Stat> byKernel();
+
+        // Chrome trace_event JSON, for chrome://tracing or Perfetto
+        string toChromeTrace();
+        // tables of the statistics by op type and by kernel
+        string summary();
+
+    private:
+        template <typename Key>
+        std::map<string, Stat> aggregate(Key key);
+    };
+
+} // namespace infini
@@ -2,6 +2,9 @@
 #include "core/common.h"
 #include "core/op_type.h"
 #include "core/ref.h"
+#include "utils/function_ref.h"
+#include <future>
+#include <mutex>
 
 namespace infini
 {
@@ -10,6 +13,9 @@ namespace infini
   class GraphObj;
   class RuntimeObj;
   class BlobObj;
+  class ThreadPool;
+  class Profiler;
+  class GraphInstance;
 
   using Tensor = Ref<TensorObj>;
   using Operator = Ref<OperatorObj>;
@@ -29,6 +35,8 @@ namespace infini
   {
   protected:
     Device device;
+    // default alignment of the tensors of the graphs on this runtime
+    size_t tensorAlignment = sizeof(uint64_t);
 
   public:
     explicit RuntimeObj(Device device)
@@ -41,16 +49,96 @@ namespace infini
     virtual void *alloc(size_t size) = 0;
     virtual void dealloc(void *ptr) = 0;
 
+    Device getDevice() const { return device; }
+
+    /**
+     * @brief Sets the alignment of the tensors of the graphs created later on
+     * this runtime, e.g. 64 to place every tensor on its own cache lines.
+     */
+    void setTensorAlignment(size_t alignment)
+    {
+      IT_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+                "Alignment must be a power of two");
+      tensorAlignment = alignment;
+    }
+    size_t getTensorAlignment() const { return tensorAlignment; }
+
     bool isCpu() const
     {
       return true;
     }
 
+    /**
+     * @brief Calls body(begin, end) on chunks of [0, n) of at least `grain`
+     * iterations, possibly at the same time, and returns when all are done.
+     * Kernels use it to split their work.
+     */
+    virtual void parallelFor(size_t n,
+                             FunctionRef<void(size_t, size_t)> body,
+                             size_t grain = 1) const
+    {
+      if (n > 0)
+        body(0, n);
+    }
+
     virtual string toString() const = 0;
   };
 
+  enum class CpuAllocMode
+  {
+    // zero-filled memory from calloc, aligned to 8 bytes
+    Zeroed = 0,
+    // uninitialized memory aligned to the configured alignment
+    Aligned,
+    // uninitialized anonymous mapping aligned to 2 MiB and advised to be
+    // backed by transparent huge pages
+    HugePage,
+  };
+
+  /**
+   * @brief A graph compiled by NativeCpuRuntimeObj::compile, with the kernel of
+   * every operator bound to its data pointers and parameters. It stays valid
+   * as long as the graph is neither changed nor planned again.
+   */
+  struct ExecutionPlan
+  {
+    // operators in topological order
+    OpVec ops;
+    // kernel launch of every operator
+    vector<std::function<void()>> launches;
+    // name of the kernel of every operator
+    vector<string> kernels;
+    // operators waiting for every operator, see setInterOpParallel
+    vector<vector<size_t>> successors;
+  };
+
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+  private:
+    CpuAllocMode allocMode = CpuAllocMode::Zeroed;
+    size_t alignment = 64;
+    // length of the mappings made in HugePage mode, keyed by pointer
+    std::unordered_map<void *, size_t> mappings;
+    // guards mappings, alloc and dealloc may be called from several threads
+    std::mutex mappingsMutex;
+    // workers shared by parallelFor and the inter-op scheduler, null when
+    // everything runs on the calling thread
+    Ref<ThreadPool> pool;
+    bool interOpParallel = false;
+    // workers running the graph instances submitted by runAsync, created on
+    // first use
+    Ref<ThreadPool> requestPool;
+    size_t requestThreads = 0;
+    std::mutex requestPoolMutex;
+    bool kernelTuning = false;
+    // index of the fastest kernel among the kernels of an op type, keyed by
+    // shape signature
+    mutable std::map<vector<int64_t>, size_t> tunedKernels;
+    mutable std::mutex tunedKernelsMutex;
+    // records of the last profiling, null if it was never enabled
+    Ref<Profiler> profiler;
+    bool profiling = false;
+
   public:
     NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
 
@@ -62,8 +150,88 @@ namespace infini
     }
     void dealloc(void *ptr) override;
     void run(const Graph &graph) const override;
+    /**
+     * @brief Resolves the kernels of a graph once, after its dataMalloc.
+     * Running the plan only does the kernel work.
+     */
+    ExecutionPlan compile(const Graph &graph) const;
+    void run(const ExecutionPlan &plan) const;
     void *alloc(size_t size) override;
     string toString() const override;
+
+    /**
+     * @brief Sets how the following calls to alloc get memory. `alignment`
+     * must be a power of two, it is used by the Aligned mode.
+     */
+    void setAllocMode(CpuAllocMode mode, size_t alignment = 64);
+    CpuAllocMode getAllocMode() const { return allocMode; }
+    size_t getAlignment() const { return alignment; }
+
+    /**
+     * @brief Sets the number of threads of the pool shared by the kernels
+     * (parallelFor) and the inter-op scheduler, 1 (the default) runs
+     * everything on the calling thread. With `pinThreads`, each worker is
+     * pinned to its own CPU among those the process may run on. Must not be
+     * called while a graph runs.
+     */
+    void setNumThreads(size_t numThreads, bool pinThreads = false);
+    size_t getNumThreads() const;
+
+    /**
+     * @brief Runs independent operators of a graph at the same time on the
+     * shared pool, instead of one by one in topological order. Operators
+     * splitting their work with parallelFor take idle workers only, so the
+     * two kinds of parallelism never use more threads than the pool has.
+     */
+    void setInterOpParallel(bool enabled) { interOpParallel = enabled; }
+    bool isInterOpParallel() const { return interOpParallel; }
+
+    void parallelFor(size_t n, FunctionRef<void(size_t, size_t)> body,
+                     size_t grain = 1) const override;
+
+    /**
+     * @brief Runs a graph instance on the request pool. Several instances,
+     * of one graph or not, may run at the same time. The instance is kept
+     * alive until it has run, and errors are rethrown by the future.
+     */
+    std::future<void> runAsync(const Ref<GraphInstance> &instance);
+
+    /**
+     * @brief Sets the number of threads running the instances submitted by
+     * runAsync, by default the number of hardware threads. Must be called
+     * before the first runAsync.
+     */
+    void setRequestThreads(size_t numThreads);
+
+    /**
+     * @brief Enables choosing among the kernels registered for an op type by
+     * timing each of them on the shapes of an op the first time they are
+     * seen. The fastest one is cached per op type, attributes, data type and
+     * shapes.
+     * When disabled, the default kernel of each op type runs.
+     */
+    void setKernelTuning(bool enabled) { kernelTuning = enabled; }
+    bool isKernelTuning() const { return kernelTuning; }
+    // number of shape signatures with a tuned kernel
+    size_t getTunedKernelCount() const;
+    void clearTunedKernels();
+
+    /**
+     * @brief Enables or disables timing every kernel call of the following
+     * runs. Enabling starts a new profiler, whose records are kept after
+     * disabling.
+     */
+    void setProfiling(bool enabled);
+    bool isProfiling() const { return profiling; }
+    Ref<Profiler> getProfiler() const { return profiler; }
+
+  private:
+    void runParallel(const ExecutionPlan &plan) const;
+    // index of the kernel running op among the kernels of its op type
+    size_t selectKernel(const Operator &op) const;
+    size_t tuneKernel(const Operator &op) const;
+    // runs the idx-th operator of a plan, timing it when profiling
+    void launch(const ExecutionPlan &plan, size_t idx) const;
   };
 
 } // namespace infini
@@ -0,0 +1,64 @@
+#pragma once
+#include "core/graph_instance.h"
+#include "core/thread_pool.h"
+
+namespace infini
+{
+    /**
+     * @brief Runs a graph on a sequence of requests over several activation
+     * arenas. While a request computes in one arena, the outputs of the
+     * previous request are handed to the callback and the inputs of the next
+     * one are staged into another arena.
+     *
+     * The graph must be planned by dataMalloc before, and neither changed nor
+     * planned again while the stream exists. Constant tensors are shared by
+     * all arenas.
+     */
+    class Stream
+    {
+    public:
+        // data of the non-constant graph inputs of a request, in the order
+        // of GraphObj::getInputs
+        using Request = vector<const void *>;
+        // called with the index of a request and the data of the graph
+        // outputs, in the order of GraphObj::getOutputs. The data is only
+        // valid during the call.
+        using Callback =
+            std::function<void(size_t, const vector<const void *> &)>;
+
+    private:
+        struct Arena
+        {
+            Ref<GraphInstance> instance;
+            // data of the graph inputs and outputs in this arena
+            vector<void *> inputs;
+            vector<const void *> outputs;
+        };
+
+        Graph graph;
+        Ref<NativeCpuRuntimeObj> runtime;
+        TensorVec inputs;
+        vector<Arena> arenas;
+        // computes one request at a time
+        ThreadPool worker;
+
+    public:
+        /**
+         * @brief Creates `depth` instances of the graph as arenas, at least 2
+         * for requests to overlap.
+         */
+        explicit Stream(const Graph &graph, size_t depth = 2);
+
+        /**
+         * @brief Runs the requests in order and calls `callback` with the
+         * outputs of each of them, on the calling thread.
+         */
+        void run(const vector<Request> &requests, const Callback &callback);
+
+        size_t getDepth() const { return arenas.size(); }
+
+    private:
+        void stage(const Request &request, Arena &arena) const;
+    };
+
+} // namespace infini
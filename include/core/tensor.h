@@ -24,6 +24,8 @@ namespace infini
         WRef<OperatorObj> source;
         Blob data;
         Runtime runtime;
+        // constant graph inputs such as weights live in a persistent region
+        bool constant = false;
 
     private:
         Shape shape;
@@ -48,6 +50,7 @@ namespace infini
             std::function<void(void *, size_t, DataType)> const &generator) const;
 
         void setDataBlob(const Blob &blob);
+        Blob getDataBlob() const { return data; }
 
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
@@ -69,6 +72,14 @@ namespace infini
             return data->getPtr<T>();
         }
 
+        /**
+         * @brief Marks a graph input as constant. Constant tensors are
+         * allocated once, apart from the activations, and keep their data
+         * when the graph is planned again.
+         */
+        void setConstant() { constant = true; }
+        bool isConstant() const { return constant; }
+
         DataType getDType() const { return dtype; }
         Runtime getRuntime() const { return runtime; }
 
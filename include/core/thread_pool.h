@@ -0,0 +1,52 @@
+#pragma once
+#include "core/common.h"
+#include "utils/function_ref.h"
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace infini
+{
+    /**
+     * @brief A fixed set of worker threads running submitted tasks in FIFO
+     * order.
+     */
+    class ThreadPool
+    {
+    private:
+        vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stop = false;
+
+    public:
+        /**
+         * @brief Starts `numThreads` workers. With `pinThreads`, the i-th
+         * worker only runs on the i-th CPU the process is allowed to run on
+         * (modulo the number of them).
+         */
+        explicit ThreadPool(size_t numThreads, bool pinThreads = false);
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        ~ThreadPool();
+
+        void submit(std::function<void()> task);
+        size_t size() const { return workers.size(); }
+
+        /**
+         * @brief Calls body(begin, end) on chunks of [0, n) of at least
+         * `grain` iterations, on the workers and the calling thread, and
+         * returns when all chunks are done. The caller takes chunks itself
+         * until none is left, so it never waits for a busy pool to start, and
+         * parallelFor may be called from tasks of the same pool.
+         */
+        void parallelFor(size_t n, size_t grain,
+                         FunctionRef<void(size_t, size_t)> body);
+
+    private:
+        void work();
+    };
+
+} // namespace infini
@@ -44,6 +44,7 @@ namespace infini
 
         std::string toString() const override;
         optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+        vector<int64_t> getOpAttrVector() const override;
 
         int numInputs() const override { return inputs.size(); }
         int numOutputs() const override { return 1; }
@@ -35,6 +35,7 @@ namespace infini
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
 
     std::string toString() const override;
+    vector<int64_t> getOpAttrVector() const override;
     std::optional<float> getMin() const { return minValue; };
     std::optional<float> getMax() const { return maxValue; };
     int numInputs() const override { return 1; }
@@ -82,6 +83,7 @@ namespace infini
     vector<DataType> inferDataType(const TensorVec &inputs) const override;
 
     std::string toString() const override;
+    vector<int64_t> getOpAttrVector() const override;
     CastType getType() const { return castType; }
     DataType getOutputDataType() const;
     int numInputs() const override { return 1; }
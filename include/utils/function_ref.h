@@ -0,0 +1,33 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+namespace infini {
+
+template <typename Fn> class FunctionRef;
+
+// A non-owning reference to a callable, which unlike std::function never
+// allocates. The callable must outlive the reference.
+template <typename R, typename... Args> class FunctionRef<R(Args...)> {
+    void *obj;
+    R (*callback)(void *, Args...);
+
+  public:
+    template <typename F,
+              typename = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<F>, FunctionRef> &&
+                  std::is_invocable_r_v<R, F &, Args...>>>
+    FunctionRef(F &&f)
+        : obj(const_cast<void *>(
+              static_cast<const void *>(std::addressof(f)))),
+          callback([](void *obj, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F> *>(obj))(
+                  std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const {
+        return callback(obj, std::forward<Args>(args)...);
+    }
+};
+
+} // namespace infini
@@ -0,0 +1,24 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+    // Levels of the messages the library prints to stdout
+    enum class LogLevel
+    {
+        // nothing is printed
+        Quiet = 0,
+        // the state of the allocators after planning and real allocations
+        Info,
+    };
+
+    /**
+     * @brief The most detailed level printed, Info by default. Messages of
+     * higher levels are dropped.
+     */
+    LogLevel getLogLevel();
+    void setLogLevel(LogLevel level);
+
+    inline bool logEnabled(LogLevel level) { return level <= getLogLevel(); }
+
+} // namespace infini
@@ -0,0 +1,138 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+    // Instruction sets with dedicated kernels, ordered by width
+    enum class CpuIsa
+    {
+        Generic = 0,
+        AVX2,
+        AVX512,
+    };
+
+    string toString(CpuIsa isa);
+
+    /**
+     * @brief The widest instruction set of this CPU that the build has
+     * kernels for, detected with CPUID on first use.
+     */
+    CpuIsa detectCpuIsa();
+
+    /**
+     * @brief The instruction set the kernels dispatch to, detectCpuIsa() by
+     * default. Lowering it is meant for comparing the kernels of every level.
+     */
+    CpuIsa getCpuIsa();
+    void setCpuIsa(CpuIsa isa);
+
+    /**
+     * @brief Vectorized loops over contiguous rows. A null entry means the
+     * instruction set has no kernel for it, and the caller runs its portable
+     * loop instead.
+     */
+    template <typename T>
+    struct SimdOps
+    {
+        // c[i] = a[i * strideA] op b[i * strideB], the strides are 0 or 1
+        using Binary = void (*)(const T *a, size_t strideA, const T *b,
+                                size_t strideB, T *c, size_t n);
+        Binary add = nullptr, sub = nullptr, mul = nullptr, div = nullptr;
+        // y[i] = max(x[i], 0)
+        void (*relu)(const T *x, T *y, size_t n) = nullptr;
+        // y[i] = x[i] < lo ? lo : x[i] > hi ? hi : x[i]
+        void (*clip)(const T *x, T *y, size_t n, T lo, T hi) = nullptr;
+        // dst[j * dstStride + i] = src[i * srcStride + j] for i, j < 8
+        void (*transpose8x8)(const T *src, size_t srcStride, T *dst,
+                             size_t dstStride) = nullptr;
+    };
+
+    /**
+     * @brief The loops of getCpuIsa() for Float32 (float) and UInt32
+     * (uint32_t) data. The tables of an instruction set are built the first
+     * time it is dispatched to, so a CPU never runs code of a wider set.
+     */
+    template <typename T>
+    const SimdOps<T> &getSimdOps();
+
+    // Whether the tables of `isa` were built by getSimdOps
+    bool isSimdTableBuilt(CpuIsa isa);
+
+    struct SimdTables
+    {
+        const SimdOps<float> *f32;
+        const SimdOps<uint32_t> *u32;
+    };
+
+    // Defined by the translation units built for each instruction set, null
+    // tables if the compiler does not target it. Building the tables runs
+    // instructions of the set, has*Kernels() are safe on any CPU.
+    SimdTables getAvx2Tables();
+    SimdTables getAvx512Tables();
+    bool hasAvx2Kernels();
+    bool hasAvx512Kernels();
+
+    /**
+     * @brief Row loops shared by the instruction set specific translation
+     * units. `V` wraps a vector register of `V::width` lanes; tails shorter
+     * than a register go through a zero padded copy.
+     */
+    template <typename V, typename V::Reg (*op)(typename V::Reg,
+                                                typename V::Reg)>
+    void simdBinaryRow(const typename V::T *a, size_t strideA,
+                       const typename V::T *b, size_t strideB,
+                       typename V::T *c, size_t n)
+    {
+        using T = typename V::T;
+        constexpr size_t W = V::width;
+        size_t i = 0;
+        if (strideA && strideB)
+            for (; i + W <= n; i += W)
+                V::store(c + i, op(V::load(a + i), V::load(b + i)));
+        else if (strideA)
+        {
+            auto y = V::set1(*b);
+            for (; i + W <= n; i += W)
+                V::store(c + i, op(V::load(a + i), y));
+        }
+        else
+        {
+            auto x = V::set1(*a);
+            for (; i + W <= n; i += W)
+                V::store(c + i, op(x, V::load(b + i)));
+        }
+        if (i < n)
+        {
+            T ta[W] = {}, tb[W] = {}, tc[W];
+            for (size_t j = 0; i + j < n; ++j)
+            {
+                ta[j] = a[strideA * (i + j)];
+                tb[j] = b[strideB * (i + j)];
+            }
+            V::store(tc, op(V::load(ta), V::load(tb)));
+            for (size_t j = 0; i + j < n; ++j)
+                c[i + j] = tc[j];
+        }
+    }
+
+    template <typename V, typename F>
+    void simdUnaryRow(const typename V::T *x, typename V::T *y, size_t n,
+                      F f)
+    {
+        using T = typename V::T;
+        constexpr size_t W = V::width;
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+            V::store(y + i, f(V::load(x + i)));
+        if (i < n)
+        {
+            T tx[W] = {}, ty[W];
+            for (size_t j = 0; i + j < n; ++j)
+                tx[j] = x[i + j];
+            V::store(ty, f(V::load(tx)));
+            for (size_t j = 0; i + j < n; ++j)
+                y[i + j] = ty[j];
+        }
+    }
+
+} // namespace infini
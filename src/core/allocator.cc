@@ -1,4 +1,8 @@
 #include "core/allocator.h"
+#include "utils/log.h"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <utility>
 
 namespace infini
@@ -7,63 +11,191 @@ namespace infini
     {
         used = 0;
         peak = 0;
+        padding = 0;
         ptr = nullptr;
+        rawPtr = nullptr;
+        capacity = 0;
 
-        // 'alignment' defaults to sizeof(uint64_t), because it is the length of
+        // 'alignment' defaults to the tensor alignment of the runtime, which
+        // is sizeof(uint64_t) unless configured, because it is the length of
         // the longest data type currently supported by the DataType field of
         // the tensor
-        alignment = sizeof(uint64_t);
+        alignment = runtime->getTensorAlignment();
     }
 
     Allocator::~Allocator()
     {
-        if (this->ptr != nullptr)
+        if (this->rawPtr != nullptr)
         {
-            runtime->dealloc(this->ptr);
+            runtime->dealloc(this->rawPtr);
         }
     }
 
+    void Allocator::setAlignment(size_t alignment)
+    {
+        IT_ASSERT(this->ptr == nullptr && this->peak == 0,
+                  "Alignment must be set before any allocation");
+        IT_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+                  "Alignment must be a power of two, got " +
+                      std::to_string(alignment));
+        this->alignment = alignment;
+    }
+
     size_t Allocator::alloc(size_t size)
     {
         IT_ASSERT(this->ptr == nullptr);
         // pad the size to the multiple of alignment
-        size = this->getAlignedSize(size);
+        size_t alignedSize = this->getAlignedSize(size);
+        this->padding += alignedSize - size;
+        size = alignedSize;
 
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来分配内存，返回起始地址偏移量
-        // =================================== 作业 ===================================
+        // best fit: the smallest free block that can hold the request
+        auto fit = freeBlocksBySize.lower_bound({size, 0});
+        if (fit != freeBlocksBySize.end())
+        {
+            auto [blockSize, addr] = *fit;
+            eraseFreeBlock(freeBlocks.find(addr));
+            if (blockSize > size)
+            {
+                insertFreeBlock(addr + size, blockSize - size);
+            }
+            this->used += size;
+            return addr;
+        }
 
-        return 0;
+        // no free block is large enough; grow the free block at the end of the
+        // memory if there is one, otherwise append a new block
+        size_t addr = this->peak;
+        if (!freeBlocks.empty())
+        {
+            auto last = std::prev(freeBlocks.end());
+            if (last->first + last->second == this->peak)
+            {
+                addr = last->first;
+                eraseFreeBlock(last);
+            }
+        }
+        this->peak = addr + size;
+        this->used += size;
+        return addr;
     }
 
     void Allocator::free(size_t addr, size_t size)
     {
         IT_ASSERT(this->ptr == nullptr);
-        size = getAlignedSize(size);
+        size_t alignedSize = getAlignedSize(size);
+        IT_ASSERT(alignedSize - size <= this->padding);
+        this->padding -= alignedSize - size;
+        size = alignedSize;
 
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来回收内存
-        // =================================== 作业 ===================================
+        IT_ASSERT(addr + size <= this->peak);
+        IT_ASSERT(size <= this->used);
+        this->used -= size;
+
+        // merge with the free block right after the freed one
+        auto next = freeBlocks.find(addr + size);
+        if (next != freeBlocks.end())
+        {
+            size += next->second;
+            eraseFreeBlock(next);
+        }
+        // merge with the free block right before the freed one
+        auto prev = freeBlocks.lower_bound(addr);
+        if (prev != freeBlocks.begin())
+        {
+            --prev;
+            IT_ASSERT(prev->first + prev->second <= addr,
+                      "Double free at offset " + std::to_string(addr));
+            if (prev->first + prev->second == addr)
+            {
+                addr = prev->first;
+                size += prev->second;
+                eraseFreeBlock(prev);
+            }
+        }
+        insertFreeBlock(addr, size);
     }
 
     void *Allocator::getPtr()
     {
         if (this->ptr == nullptr)
         {
-            this->ptr = runtime->alloc(this->peak);
-            printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
+            // malloc-like runtimes only guarantee the alignment of
+            // max_align_t, ask for more memory to align the head address
+            size_t extra =
+                this->alignment > alignof(std::max_align_t) ? this->alignment : 0;
+            size_t size = this->peak + extra;
+            if (this->rawPtr == nullptr || this->capacity < size)
+            {
+                if (this->rawPtr != nullptr)
+                {
+                    runtime->dealloc(this->rawPtr);
+                }
+                this->rawPtr = runtime->alloc(size);
+                this->capacity = size;
+                if (logEnabled(LogLevel::Info))
+                    printf("Allocator really alloc: %p %lu bytes\n",
+                           this->rawPtr, size);
+            }
+            auto addr = reinterpret_cast<uintptr_t>(this->rawPtr);
+            this->ptr = reinterpret_cast<void *>(
+                (addr + this->alignment - 1) / this->alignment * this->alignment);
         }
         return this->ptr;
     }
 
+    void Allocator::reset()
+    {
+        used = 0;
+        peak = 0;
+        padding = 0;
+        ptr = nullptr;
+        freeBlocks.clear();
+        freeBlocksBySize.clear();
+    }
+
+    void Allocator::reserve(size_t size)
+    {
+        IT_ASSERT(this->ptr == nullptr);
+        this->peak = std::max(this->peak, size);
+    }
+
     size_t Allocator::getAlignedSize(size_t size)
     {
         return ((size - 1) / this->alignment + 1) * this->alignment;
     }
 
+    void Allocator::insertFreeBlock(size_t addr, size_t size)
+    {
+        freeBlocks.emplace(addr, size);
+        freeBlocksBySize.emplace(size, addr);
+    }
+
+    void Allocator::eraseFreeBlock(std::map<size_t, size_t>::iterator it)
+    {
+        freeBlocksBySize.erase({it->second, it->first});
+        freeBlocks.erase(it);
+    }
+
+    double Allocator::getFragmentation() const
+    {
+        size_t totalFree = this->peak - this->used;
+        // memory added by reserve() is not tracked as a free block
+        if (totalFree == 0 || freeBlocksBySize.empty())
+        {
+            return 0.;
+        }
+        size_t largestFree = freeBlocksBySize.rbegin()->first;
+        return 1. - (double)largestFree / totalFree;
+    }
+
     void Allocator::info()
     {
         std::cout << "Used memory: " << this->used
-                  << ", peak memory: " << this->peak << std::endl;
+                  << ", peak memory: " << this->peak
+                  << ", alignment: " << this->alignment
+                  << ", padding: " << this->padding
+                  << ", free blocks: " << freeBlocks.size()
+                  << ", fragmentation: " << getFragmentation() << std::endl;
     }
 }
@@ -0,0 +1,43 @@
+#include "core/frozen_graph.h"
+
+namespace infini
+{
+    FrozenGraph::FrozenGraph(const Graph &graph) : graph(graph)
+    {
+        auto runtime = as<NativeCpuRuntimeObj>(graph->getRuntime());
+        IT_ASSERT(runtime != nullptr, "Frozen graphs run on the CPU runtime");
+        auto plan = runtime->compile(graph);
+
+        std::unordered_map<TensorObj *, size_t> index;
+        for (auto &tensor : graph->getTensors())
+        {
+            index.emplace(tensor.get(), tensors.size());
+            tensors.push_back({tensor->getFuid(), tensor->getDType(),
+                               tensor->getDims(), tensor->getBytes(),
+                               tensor->getRawDataPtr<void *>()});
+        }
+        for (size_t i = 0; i < plan.ops.size(); ++i)
+        {
+            auto &op = plan.ops[i];
+            OpInfo info{op->getGuid(), op->getOpType(), plan.kernels[i], {}, {}};
+            for (auto &input : op->getInputs())
+                info.inputs.push_back(index.at(input.get()));
+            for (auto &output : op->getOutputs())
+                info.outputs.push_back(index.at(output.get()));
+            ops.emplace_back(std::move(info));
+        }
+        launches = std::move(plan.launches);
+        for (auto &tensor : graph->getInputs())
+            if (!tensor->isConstant())
+                inputs.push_back(index.at(tensor.get()));
+        for (auto &tensor : graph->getOutputs())
+            outputs.push_back(index.at(tensor.get()));
+    }
+
+    void FrozenGraph::run() const
+    {
+        for (auto &launch : launches)
+            launch();
+    }
+
+} // namespace infini
@@ -1,4 +1,6 @@
 #include "core/graph.h"
+#include "core/kernel.h"
+#include "utils/log.h"
 #include <algorithm>
 #include <numeric>
 #include <queue>
@@ -133,27 +135,262 @@ namespace infini
             {
                 auto newShape = ans.value()[i];
                 auto oldShape = oldOutputs[i]->getDims();
-                auto fuid = oldOutputs[i]->getFuid();
                 if (newShape != oldShape)
                 {
-                    auto tensor = this->getTensor(fuid);
-                    tensor->setShape(newShape);
+                    oldOutputs[i]->setShape(newShape);
                 }
             }
         }
     }
 
-    void GraphObj::dataMalloc()
+    bool GraphObj::setInputShapes(
+        const vector<std::pair<Tensor, Shape>> &shapes,
+        MemoryPlanStrategy strategy)
+    {
+        IT_ASSERT(topo_sort() == true);
+
+        std::unordered_set<TensorObj *> changed;
+        // some tensor needs more memory than it has in the current plan
+        bool grown = false;
+        auto reshape = [&](const Tensor &tensor, const Shape &shape)
+        {
+            if (tensor->getDims() == shape)
+                return;
+            auto bytes = tensor->getBytes();
+            tensor->setShape(shape);
+            grown |= tensor->getBytes() > bytes;
+            changed.insert(tensor.get());
+        };
+        for (auto &[tensor, shape] : shapes)
+        {
+            IT_ASSERT(!tensor->getSource() && !tensor->isConstant(),
+                      "Only non-constant graph inputs can be reshaped");
+            reshape(tensor, shape);
+        }
+        if (changed.empty())
+            return false;
+
+        // zero-copy concat inputs are placed by the sizes of the other inputs
+        bool slices = false;
+        // an output planned in place may share the memory of an input of
+        // another shape now, which the kernel would overwrite while reading
+        bool aliased = false;
+        for (auto &op : ops)
+        {
+            auto inputs = op->getInputs();
+            if (std::none_of(inputs.begin(), inputs.end(),
+                             [&](const Tensor &input)
+                             { return changed.count(input.get()); }))
+                continue;
+            slices |= op->getOpType() == OpType::Concat;
+            auto ans = op->inferShape();
+            IT_ASSERT(ans.has_value());
+            auto outputs = op->getOutputs();
+            IT_ASSERT(ans.value().size() == outputs.size());
+            for (size_t i = 0; i < outputs.size(); ++i)
+                reshape(outputs[i], ans.value()[i]);
+            if (outputs.size() == 1 &&
+                KernelRegistry::getInstance().isInPlaceSafe(
+                    KernelAttrs{runtime->getDevice(),
+                                op->getOpType().underlying()}))
+                aliased |= std::any_of(
+                    inputs.begin(), inputs.end(), [&](const Tensor &input)
+                    { return input->getSource() &&
+                             input->getDims() != outputs[0]->getDims(); });
+        }
+
+        // tensors no larger than before still fit in their memory
+        if (!grown && !slices && !aliased)
+            return false;
+        dataMalloc(strategy);
+        return true;
+    }
+
+    void GraphObj::dataMalloc(MemoryPlanStrategy strategy)
     {
         // topological sorting first
         IT_ASSERT(topo_sort() == true);
 
-        // =================================== 作业 ===================================
-        // TODO：利用 allocator 给计算图分配内存
-        // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
-        // =================================== 作业 ===================================
+        weightMalloc();
+        auto plan = planActivations(strategy);
+        // the memory is owned by this graph again
+        arenaOwner = nullptr;
+        bindActivations(plan, allocator.getPtr());
+
+        if (logEnabled(LogLevel::Info))
+            allocator.info();
+    }
 
-        allocator.info();
+    void GraphObj::dataMalloc(const vector<Graph> &graphs,
+                              MemoryPlanStrategy strategy)
+    {
+        IT_ASSERT(!graphs.empty());
+        // the memory is allocated with the alignment of the first graph
+        for (auto &g : graphs)
+            IT_ASSERT(g->getAlignment() == graphs[0]->getAlignment(),
+                      "Graphs sharing activations must have the same "
+                      "alignment");
+        vector<MemoryPlan> plans;
+        size_t peak = 0;
+        for (auto &g : graphs)
+        {
+            IT_ASSERT(g->topo_sort() == true);
+            IT_ASSERT(g->runtime == graphs[0]->runtime);
+            g->weightMalloc();
+            plans.emplace_back(g->planActivations(strategy));
+            peak = std::max(peak, plans.back().peak);
+        }
+        auto &owner = graphs[0];
+        owner->allocator.reserve(peak);
+        void *ptr = owner->allocator.getPtr();
+        for (size_t i = 0; i < graphs.size(); ++i)
+        {
+            graphs[i]->arenaOwner = i == 0 ? nullptr : owner;
+            graphs[i]->bindActivations(plans[i], ptr);
+        }
+        if (logEnabled(LogLevel::Info))
+            owner->allocator.info();
+    }
+
+    void GraphObj::weightMalloc()
+    {
+        TensorVec weights;
+        for (auto &tensor : tensors)
+        {
+            if (tensor->isConstant() && tensor->data == nullptr)
+            {
+                IT_ASSERT(!tensor->getSource(),
+                          "Only graph inputs can be constant");
+                weights.emplace_back(tensor);
+            }
+        }
+        if (weights.empty())
+        {
+            return;
+        }
+        IT_ASSERT(weightAllocator.getPeak() == 0,
+                  "Constant tensors must be added before the first dataMalloc");
+        vector<size_t> offsets;
+        for (auto &tensor : weights)
+        {
+            offsets.emplace_back(weightAllocator.alloc(tensor->getBytes()));
+        }
+        auto ptr = reinterpret_cast<uint8_t *>(weightAllocator.getPtr());
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            weights[i]->setDataBlob(make_ref<BlobObj>(runtime, ptr + offsets[i]));
+        }
+        if (logEnabled(LogLevel::Info))
+        {
+            std::cout << "Weights: ";
+            weightAllocator.info();
+        }
+    }
+
+    TensorVec GraphObj::getActivations() const
+    {
+        TensorVec ret;
+        ret.reserve(tensors.size());
+        for (auto &tensor : tensors)
+        {
+            if (!tensor->isConstant())
+            {
+                ret.emplace_back(tensor);
+            }
+        }
+        return ret;
+    }
+
+    MemoryPlanKey GraphObj::getPlanKey(MemoryPlanStrategy strategy) const
+    {
+        MemoryPlanKey key{(int64_t)strategy, (int64_t)allocator.getAlignment(),
+                          (int64_t)ops.size(), (int64_t)tensors.size()};
+        for (auto &op : ops)
+        {
+            key.emplace_back(op->getOpType().underlying());
+            key.emplace_back(op->getInputs().size());
+            for (auto &input : op->getInputs())
+                key.emplace_back(input->getFuid());
+            key.emplace_back(op->getOutputs().size());
+            for (auto &output : op->getOutputs())
+                key.emplace_back(output->getFuid());
+        }
+        for (auto &tensor : tensors)
+        {
+            key.emplace_back(tensor->getFuid());
+            key.emplace_back(tensor->isConstant());
+            key.emplace_back(tensor->getDType().getIndex());
+            key.emplace_back(tensor->getRank());
+            for (auto d : tensor->getDims())
+                key.emplace_back(d);
+        }
+        return key;
+    }
+
+    MemoryPlan GraphObj::planActivations(MemoryPlanStrategy strategy)
+    {
+        allocator.reset();
+        auto key = getPlanKey(strategy);
+        if (auto it = planCache.find(key); it != planCache.end())
+        {
+            allocator.reserve(it->second.peak);
+            allocator.addPadding(it->second.padding);
+            return it->second;
+        }
+        auto activations = getActivations();
+        MemoryPlanner planner(ops, activations, allocator.getAlignment());
+        auto plan = planner.plan(strategy, allocator);
+        planCache.emplace(std::move(key), plan);
+        return plan;
+    }
+
+    void GraphObj::bindActivations(const MemoryPlan &plan, void *ptr)
+    {
+        activationPlan = plan;
+        auto base = reinterpret_cast<uint8_t *>(ptr);
+        for (auto &tensor : tensors)
+        {
+            if (!tensor->isConstant())
+            {
+                tensor->setDataBlob(make_ref<BlobObj>(
+                    runtime, base + plan.offsets.at(tensor->getFuid())));
+            }
+        }
+    }
+
+    void GraphObj::bindActivations(void *ptr)
+    {
+        if (ptr == nullptr)
+            ptr = (arenaOwner ? arenaOwner->allocator : allocator).getPtr();
+        IT_ASSERT(reinterpret_cast<uintptr_t>(ptr) % getAlignment() == 0,
+                  "Activation memory is not aligned");
+        bindActivations(activationPlan, ptr);
+    }
+
+    std::map<MemoryPlanStrategy, size_t> GraphObj::compareMemoryPlans()
+    {
+        IT_ASSERT(topo_sort() == true);
+
+        auto activations = getActivations();
+        MemoryPlanner planner(ops, activations, allocator.getAlignment());
+        std::map<MemoryPlanStrategy, size_t> ret;
+        for (auto strategy :
+             {MemoryPlanStrategy::Sequential, MemoryPlanStrategy::GreedyBySize,
+              MemoryPlanStrategy::GreedyByBreadth,
+              MemoryPlanStrategy::IntervalColoring})
+        {
+            // plan on a scratch allocator, no memory is really allocated
+            Allocator scratch(runtime);
+            scratch.setAlignment(allocator.getAlignment());
+            ret[strategy] = planner.plan(strategy, scratch).peak;
+            if (logEnabled(LogLevel::Info))
+                std::cout << infini::toString(strategy)
+                          << " peak memory: " << ret[strategy] << std::endl;
+        }
+        if (logEnabled(LogLevel::Info))
+            std::cout << "Lower bound: " << planner.getLowerBound()
+                      << std::endl;
+        return ret;
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
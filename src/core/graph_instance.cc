@@ -0,0 +1,20 @@
+#include "core/graph_instance.h"
+
+namespace infini
+{
+    GraphInstance::GraphInstance(const Graph &graph)
+        : graph(graph), memory(graph->getRuntime())
+    {
+        auto runtime = as<NativeCpuRuntimeObj>(graph->getRuntime());
+        IT_ASSERT(runtime != nullptr, "Instances run on the CPU runtime");
+        memory.setAlignment(graph->getAlignment());
+        memory.reserve(graph->getMemoryPlan().peak);
+
+        graph->bindActivations(memory.getPtr());
+        plan = runtime->compile(graph);
+        for (auto &tensor : graph->getTensors())
+            data.emplace(tensor->getFuid(), tensor->getRawDataPtr<void *>());
+        graph->bindActivations(nullptr);
+    }
+
+} // namespace infini
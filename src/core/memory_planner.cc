@@ -0,0 +1,502 @@
+#include "core/memory_planner.h"
+#include "core/kernel.h"
+#include "operators/concat.h"
+#include <algorithm>
+#include <numeric>
+
+namespace infini
+{
+    string toString(MemoryPlanStrategy strategy)
+    {
+        switch (strategy)
+        {
+        case MemoryPlanStrategy::Sequential:
+            return "Sequential";
+        case MemoryPlanStrategy::GreedyBySize:
+            return "GreedyBySize";
+        case MemoryPlanStrategy::GreedyByBreadth:
+            return "GreedyByBreadth";
+        case MemoryPlanStrategy::IntervalColoring:
+            return "IntervalColoring";
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    MemoryPlanner::MemoryPlanner(const OpVec &sortedOps, const TensorVec &tensors,
+                                 size_t alignment)
+        : ops(sortedOps), tensors(tensors), alignment(alignment)
+    {
+        // the index of the last operator using each tensor, graph outputs
+        // are alive until the end
+        size_t end = ops.empty() ? 0 : ops.size() - 1;
+        std::unordered_map<TensorObj *, size_t> lastUse;
+        lastUse.reserve(tensors.size());
+        for (auto &tensor : tensors)
+            lastUse[tensor.get()] = tensor->getTargets().empty() ? end : 0;
+        for (size_t i = 0; i < ops.size(); ++i)
+            for (auto &input : ops[i]->getInputs())
+                lastUse[input.get()] = std::max(lastUse[input.get()], i);
+
+        lifetimeOf.reserve(tensors.size());
+        offsetInLifetime.reserve(tensors.size());
+        lifetimes.reserve(tensors.size());
+        auto addLifetime = [&](const Tensor &tensor, size_t first)
+        {
+            size_t size =
+                (tensor->getBytes() + alignment - 1) / alignment * alignment;
+            lifetimeOf[tensor.get()] = lifetimes.size();
+            offsetInLifetime[tensor.get()] = 0;
+            size_t last = lastUse.at(tensor.get());
+            lifetimes.push_back({{{tensor, 0, first, last}},
+                                 size,
+                                 first,
+                                 last,
+                                 tensor->getBytes(),
+                                 tensor->getTargets().empty()});
+        };
+        // graph inputs are alive from the beginning
+        for (auto &tensor : tensors)
+            if (!tensor->getSource())
+                addLifetime(tensor, 0);
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            if (!tryInPlace(i, lastUse))
+                for (auto &output : ops[i]->getOutputs())
+                    addLifetime(output, i);
+            if (ops[i]->getOpType() == OpType::Concat)
+                tryZeroCopyConcat(i);
+        }
+
+        // drop the lifetimes merged into others
+        vector<TensorLifetime> merged;
+        merged.reserve(lifetimes.size());
+        for (auto &lifetime : lifetimes)
+        {
+            if (lifetime.tensors.empty())
+                continue;
+            for (auto &member : lifetime.tensors)
+                lifetimeOf[member.tensor.get()] = merged.size();
+            merged.emplace_back(std::move(lifetime));
+        }
+        lifetimes = std::move(merged);
+    }
+
+    bool MemoryPlanner::tryInPlace(
+        size_t idx, const std::unordered_map<TensorObj *, size_t> &lastUse)
+    {
+        const auto &op = ops[idx];
+        if (op->numOutputs() != 1)
+            return false;
+        auto output = op->getOutput();
+        auto kernelAttrs = KernelAttrs{output->getRuntime()->getDevice(),
+                                       op->getOpType().underlying()};
+        if (!KernelRegistry::getInstance().isInPlaceSafe(kernelAttrs))
+            return false;
+        for (auto &input : op->getInputs())
+        {
+            // graph inputs are written by the user and must survive a run
+            if (!input->getSource() || lastUse.at(input.get()) != idx ||
+                input->getDims() != output->getDims() ||
+                input->getBytes() != output->getBytes())
+                continue;
+            // the whole memory must die here, not only the input's slice
+            auto &lifetime = lifetimes[lifetimeOf.at(input.get())];
+            if (lifetime.last != idx || offsetInLifetime.at(input.get()) != 0 ||
+                lifetime.headBytes != input->getBytes() ||
+                lifetime.holdsGraphOutput)
+                continue;
+            lifetime.last = lastUse.at(output.get());
+            lifetime.holdsGraphOutput = output->getTargets().empty();
+            lifetime.tensors.push_back({output, 0, idx, lifetime.last});
+            lifetimeOf[output.get()] = lifetimeOf.at(input.get());
+            offsetInLifetime[output.get()] = 0;
+            return true;
+        }
+        return false;
+    }
+
+    void MemoryPlanner::tryZeroCopyConcat(size_t idx)
+    {
+        auto op = as<ConcatObj>(ops[idx]);
+        auto output = op->getOutput();
+        auto outDims = output->getDims();
+        // inputs are contiguous slices of the output only if every dimension
+        // before the concatenated one is 1
+        for (int i = 0; i < op->getDim(); ++i)
+            if (outDims[i] != 1)
+                return;
+
+        size_t outIdx = lifetimeOf.at(output.get());
+        size_t offset = offsetInLifetime.at(output.get());
+        const auto &inputs = op->getInputs();
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const auto &input = inputs[i];
+            // the input must be produced by an operator into its own memory
+            // and read only by this Concat, and keep the alignment of every
+            // tensor as a slice
+            if (offset % alignment == 0 && input->getSource() &&
+                input->getTargets().size() == 1 &&
+                std::count(inputs.begin(), inputs.end(), input) == 1)
+            {
+                size_t inIdx = lifetimeOf.at(input.get());
+                if (lifetimes[inIdx].tensors.size() == 1 && inIdx != outIdx)
+                    mergeLifetime(inIdx, outIdx, offset);
+            }
+            offset += input->getBytes();
+        }
+    }
+
+    void MemoryPlanner::mergeLifetime(size_t from, size_t to, size_t offset)
+    {
+        auto &src = lifetimes[from], &dst = lifetimes[to];
+        for (auto &member : src.tensors)
+        {
+            dst.tensors.push_back({member.tensor, offset + member.offset,
+                                   member.first, member.last});
+            lifetimeOf[member.tensor.get()] = to;
+            offsetInLifetime[member.tensor.get()] = offset + member.offset;
+        }
+        dst.first = std::min(dst.first, src.first);
+        dst.last = std::max(dst.last, src.last);
+        dst.holdsGraphOutput |= src.holdsGraphOutput;
+        src.tensors.clear();
+    }
+
+    void MemoryPlanner::setOffset(MemoryPlan &plan, size_t idx,
+                                  size_t offset) const
+    {
+        for (auto &member : lifetimes[idx].tensors)
+            plan.offsets[member.tensor->getFuid()] = offset + member.offset;
+        plan.peak = std::max(plan.peak, offset + lifetimes[idx].size);
+    }
+
+    MemoryPlan MemoryPlanner::plan(MemoryPlanStrategy strategy,
+                                   Allocator &allocator) const
+    {
+        MemoryPlan ret;
+        switch (strategy)
+        {
+        case MemoryPlanStrategy::Sequential:
+            ret = planSequential(allocator);
+            record(ret);
+            // the lifetimes are aligned already, so the allocator added none
+            allocator.addPadding(ret.padding);
+            return ret;
+        case MemoryPlanStrategy::GreedyBySize:
+            ret = planGreedyBySize();
+            break;
+        case MemoryPlanStrategy::GreedyByBreadth:
+            ret = planGreedyByBreadth();
+            break;
+        case MemoryPlanStrategy::IntervalColoring:
+            ret = planIntervalColoring();
+            break;
+        default:
+            IT_TODO_HALT();
+        }
+        if (ret.peak > 0)
+        {
+            size_t base = allocator.alloc(ret.peak);
+            for (auto &[fuid, offset] : ret.offsets)
+                offset += base;
+        }
+        record(ret);
+        allocator.addPadding(ret.padding);
+        return ret;
+    }
+
+    void MemoryPlanner::record(MemoryPlan &plan) const
+    {
+        plan.padding = 0;
+        for (auto &lifetime : lifetimes)
+            plan.padding += lifetime.size - lifetime.headBytes;
+
+        plan.tensors.clear();
+        plan.tensors.reserve(tensors.size());
+        std::unordered_map<TensorObj *, const TensorLifetime::Member *> members;
+        for (auto &lifetime : lifetimes)
+            for (auto &member : lifetime.tensors)
+                members[member.tensor.get()] = &member;
+        for (auto &tensor : tensors)
+        {
+            auto member = members.at(tensor.get());
+            plan.tensors.push_back({tensor->getFuid(),
+                                    plan.offsets.at(tensor->getFuid()),
+                                    tensor->getBytes(), member->first,
+                                    member->last});
+        }
+
+        // sweep the operators, keeping the ends of the alive memory blocks
+        vector<vector<size_t>> startAt(ops.size()), endAfter(ops.size());
+        vector<size_t> blockEnd(lifetimes.size());
+        for (size_t idx = 0; idx < lifetimes.size(); ++idx)
+        {
+            const auto &front = lifetimes[idx].tensors.front();
+            blockEnd[idx] = plan.offsets.at(front.tensor->getFuid()) -
+                            front.offset + lifetimes[idx].size;
+            if (ops.empty())
+                continue;
+            startAt[lifetimes[idx].first].emplace_back(idx);
+            endAfter[lifetimes[idx].last].emplace_back(idx);
+        }
+        plan.timeline.clear();
+        plan.timeline.reserve(ops.size());
+        std::multiset<size_t> ends;
+        size_t live = 0;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            for (auto idx : startAt[i])
+            {
+                live += lifetimes[idx].size;
+                ends.insert(blockEnd[idx]);
+            }
+            size_t footprint = ends.empty() ? 0 : *ends.rbegin();
+            plan.timeline.push_back(
+                {live, footprint,
+                 footprint == 0 ? 0. : 1. - (double)live / footprint});
+            for (auto idx : endAfter[i])
+            {
+                live -= lifetimes[idx].size;
+                ends.erase(ends.find(blockEnd[idx]));
+            }
+        }
+    }
+
+    string MemoryPlan::tensorsToCsv() const
+    {
+        std::ostringstream os;
+        os << "fuid,offset,bytes,first,last\n";
+        for (auto &t : tensors)
+            os << t.fuid << "," << t.offset << "," << t.bytes << "," << t.first
+               << "," << t.last << "\n";
+        return os.str();
+    }
+
+    string MemoryPlan::timelineToCsv() const
+    {
+        std::ostringstream os;
+        os << "op,live,footprint,fragmentation\n";
+        for (size_t i = 0; i < timeline.size(); ++i)
+            os << i << "," << timeline[i].live << "," << timeline[i].footprint
+               << "," << timeline[i].fragmentation << "\n";
+        return os.str();
+    }
+
+    string MemoryPlan::toJson() const
+    {
+        std::ostringstream os;
+        os << "{\"peak\": " << peak << ", \"tensors\": [";
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            auto &t = tensors[i];
+            os << (i ? ", " : "") << "{\"fuid\": " << t.fuid
+               << ", \"offset\": " << t.offset << ", \"bytes\": " << t.bytes
+               << ", \"first\": " << t.first << ", \"last\": " << t.last
+               << "}";
+        }
+        os << "], \"timeline\": [";
+        for (size_t i = 0; i < timeline.size(); ++i)
+        {
+            auto &p = timeline[i];
+            os << (i ? ", " : "") << "{\"op\": " << i
+               << ", \"live\": " << p.live
+               << ", \"footprint\": " << p.footprint
+               << ", \"fragmentation\": " << p.fragmentation << "}";
+        }
+        os << "]}";
+        return os.str();
+    }
+
+    size_t MemoryPlanner::getLowerBound() const
+    {
+        // difference array of the live bytes over the operators
+        vector<long long> delta(ops.size() + 2, 0);
+        for (auto &lifetime : lifetimes)
+        {
+            delta[lifetime.first] += lifetime.size;
+            delta[lifetime.last + 1] -= lifetime.size;
+        }
+        size_t ret = 0;
+        long long live = 0;
+        for (auto d : delta)
+        {
+            live += d;
+            ret = std::max(ret, (size_t)live);
+        }
+        return ret;
+    }
+
+    MemoryPlan MemoryPlanner::planSequential(Allocator &allocator) const
+    {
+        vector<vector<size_t>> allocAt(ops.size()), releaseAt(ops.size());
+        vector<size_t> offsets(lifetimes.size());
+        MemoryPlan ret;
+        ret.offsets.reserve(tensors.size());
+        for (size_t idx = 0; idx < lifetimes.size(); ++idx)
+        {
+            const auto &members = lifetimes[idx].tensors;
+            auto any = [&](auto pred)
+            { return std::any_of(members.begin(), members.end(), pred); };
+            // graph inputs are written by the user before running, so they
+            // are allocated before any operator output
+            if (any([](auto &m)
+                    { return !m.tensor->getSource(); }))
+            {
+                offsets[idx] = allocator.alloc(lifetimes[idx].size);
+                setOffset(ret, idx, offsets[idx]);
+            }
+            else
+                allocAt[lifetimes[idx].first].emplace_back(idx);
+            // graph outputs are never released
+            if (!lifetimes[idx].holdsGraphOutput)
+                releaseAt[lifetimes[idx].last].emplace_back(idx);
+        }
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            // outputs are allocated before the inputs are released, so that
+            // kernels never read and write the same memory unless planned in
+            // place
+            for (auto idx : allocAt[i])
+            {
+                offsets[idx] = allocator.alloc(lifetimes[idx].size);
+                setOffset(ret, idx, offsets[idx]);
+            }
+            for (auto idx : releaseAt[i])
+                allocator.free(offsets[idx], lifetimes[idx].size);
+        }
+        ret.peak = allocator.getPeak();
+        return ret;
+    }
+
+    MemoryPlan MemoryPlanner::planGreedyBySize() const
+    {
+        vector<size_t> order(lifetimes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return lifetimes[a].size > lifetimes[b].size; });
+
+        MemoryPlan ret;
+        vector<size_t> offsets(lifetimes.size()), placed;
+        placed.reserve(lifetimes.size());
+        for (auto idx : order)
+        {
+            offsets[idx] = place(idx, placed, offsets, true);
+            placed.emplace_back(idx);
+            setOffset(ret, idx, offsets[idx]);
+        }
+        return ret;
+    }
+
+    MemoryPlan MemoryPlanner::planGreedyByBreadth() const
+    {
+        // the breadth of an operator is the total size of its inputs and
+        // outputs
+        vector<vector<size_t>> opTensors(ops.size());
+        vector<size_t> breadth(ops.size(), 0);
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            for (auto &t : ops[i]->getInputs())
+                // constant inputs are not planned
+                if (auto it = lifetimeOf.find(t.get()); it != lifetimeOf.end())
+                    opTensors[i].emplace_back(it->second);
+            for (auto &t : ops[i]->getOutputs())
+                opTensors[i].emplace_back(lifetimeOf.at(t.get()));
+            // inputs and outputs of an in-place operator share a lifetime
+            std::sort(opTensors[i].begin(), opTensors[i].end());
+            opTensors[i].erase(
+                std::unique(opTensors[i].begin(), opTensors[i].end()),
+                opTensors[i].end());
+            for (auto idx : opTensors[i])
+                breadth[i] += lifetimes[idx].size;
+            std::stable_sort(opTensors[i].begin(), opTensors[i].end(),
+                             [&](size_t a, size_t b)
+                             { return lifetimes[a].size > lifetimes[b].size; });
+        }
+        vector<size_t> opOrder(ops.size());
+        std::iota(opOrder.begin(), opOrder.end(), 0);
+        std::stable_sort(opOrder.begin(), opOrder.end(), [&](size_t a, size_t b)
+                         { return breadth[a] > breadth[b]; });
+
+        MemoryPlan ret;
+        vector<size_t> offsets(lifetimes.size()), placed;
+        vector<bool> assigned(lifetimes.size(), false);
+        placed.reserve(lifetimes.size());
+        auto assign = [&](size_t idx)
+        {
+            if (assigned[idx])
+                return;
+            assigned[idx] = true;
+            offsets[idx] = place(idx, placed, offsets, true);
+            placed.emplace_back(idx);
+            setOffset(ret, idx, offsets[idx]);
+        };
+        for (auto op : opOrder)
+            for (auto idx : opTensors[op])
+                assign(idx);
+        // tensors not connected to any operator
+        for (size_t idx = 0; idx < lifetimes.size(); ++idx)
+            assign(idx);
+        return ret;
+    }
+
+    MemoryPlan MemoryPlanner::planIntervalColoring() const
+    {
+        vector<size_t> order(lifetimes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         {
+                             if (lifetimes[a].first != lifetimes[b].first)
+                                 return lifetimes[a].first < lifetimes[b].first;
+                             return lifetimes[a].size > lifetimes[b].size; });
+
+        MemoryPlan ret;
+        vector<size_t> offsets(lifetimes.size()), placed;
+        placed.reserve(lifetimes.size());
+        for (auto idx : order)
+        {
+            offsets[idx] = place(idx, placed, offsets, false);
+            placed.emplace_back(idx);
+            setOffset(ret, idx, offsets[idx]);
+        }
+        return ret;
+    }
+
+    size_t MemoryPlanner::place(size_t idx, const vector<size_t> &placed,
+                                const vector<size_t> &offsets,
+                                bool bestFit) const
+    {
+        const auto &cur = lifetimes[idx];
+        vector<size_t> overlapped;
+        for (auto p : placed)
+        {
+            if (lifetimes[p].first <= cur.last && cur.first <= lifetimes[p].last)
+                overlapped.emplace_back(p);
+        }
+        std::sort(overlapped.begin(), overlapped.end(),
+                  [&](size_t a, size_t b)
+                  { return offsets[a] < offsets[b]; });
+
+        size_t prevEnd = 0, bestOffset = 0, bestGap = SIZE_MAX;
+        bool found = false;
+        for (auto p : overlapped)
+        {
+            if (offsets[p] >= prevEnd)
+            {
+                size_t gap = offsets[p] - prevEnd;
+                if (gap >= cur.size && gap < bestGap)
+                {
+                    found = true;
+                    bestOffset = prevEnd;
+                    bestGap = gap;
+                    if (!bestFit)
+                        break;
+                }
+            }
+            prevEnd = std::max(prevEnd, offsets[p] + lifetimes[p].size);
+        }
+        return found ? bestOffset : prevEnd;
+    }
+
+} // namespace infini
@@ -0,0 +1,120 @@
+#include "core/profiler.h"
+#include <iomanip>
+
+namespace infini
+{
+    void Profiler::add(Record record)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.emplace_back(std::move(record));
+    }
+
+    double Profiler::now() const
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - epoch)
+            .count();
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+    }
+
+    vector<Profiler::Record> Profiler::getRecords()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    template <typename Key>
+    std::map<string, Profiler::Stat> Profiler::aggregate(Key key)
+    {
+        std::map<string, Stat> ret;
+        for (auto &record : getRecords())
+        {
+            auto &stat = ret[key(record)];
+            stat.min = stat.calls ? std::min(stat.min, record.duration)
+                                  : record.duration;
+            stat.max = std::max(stat.max, record.duration);
+            stat.total += record.duration;
+            ++stat.calls;
+        }
+        return ret;
+    }
+
+    std::map<string, Profiler::Stat> Profiler::byOpType()
+    {
+        return aggregate([](const Record &record)
+                         { return string(record.opType.toString()); });
+    }
+
+    std::map<string, Profiler::Stat> Profiler::byKernel()
+    {
+        return aggregate([](const Record &record)
+                         { return record.kernel; });
+    }
+
+    string Profiler::toChromeTrace()
+    {
+        auto records = getRecords();
+        // small thread ids in the order the threads appear
+        std::map<std::thread::id, size_t> tids;
+        for (auto &record : records)
+            tids.emplace(record.thread, tids.size());
+
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(3);
+        os << "{\"traceEvents\": [";
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            auto &r = records[i];
+            auto shapes = [](const vector<Shape> &shapes)
+            {
+                string ret = "[";
+                for (size_t j = 0; j < shapes.size(); ++j)
+                    ret += (j ? ", " : "") + vecToString(shapes[j]);
+                return ret + "]";
+            };
+            os << (i ? ", " : "") << "{\"name\": \"" << r.kernel
+               << "\", \"cat\": \"" << r.opType.toString()
+               << "\", \"ph\": \"X\", \"ts\": " << r.begin
+               << ", \"dur\": " << r.duration
+               << ", \"pid\": 0, \"tid\": " << tids.at(r.thread)
+               << ", \"args\": {\"guid\": " << r.guid << ", \"inputs\": \""
+               << shapes(r.inputs) << "\", \"outputs\": \""
+               << shapes(r.outputs) << "\"}}";
+        }
+        os << "], \"displayTimeUnit\": \"ms\"}";
+        return os.str();
+    }
+
+    string Profiler::summary()
+    {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(3);
+        auto table = [&](const string &title,
+                         const std::map<string, Stat> &stats)
+        {
+            double sum = 0;
+            for (auto &[name, stat] : stats)
+                sum += stat.total;
+            os << std::left << std::setw(24) << title << std::right
+               << std::setw(8) << "calls" << std::setw(14) << "total(us)"
+               << std::setw(12) << "avg(us)" << std::setw(12) << "min(us)"
+               << std::setw(12) << "max(us)" << std::setw(9) << "%"
+               << std::endl;
+            for (auto &[name, stat] : stats)
+                os << std::left << std::setw(24) << name << std::right
+                   << std::setw(8) << stat.calls << std::setw(14) << stat.total
+                   << std::setw(12) << stat.total / stat.calls << std::setw(12)
+                   << stat.min << std::setw(12) << stat.max << std::setw(9)
+                   << (sum > 0 ? stat.total / sum * 100 : 0) << std::endl;
+        };
+        table("Op type", byOpType());
+        os << std::endl;
+        table("Kernel", byKernel());
+        return os.str();
+    }
+
+} // namespace infini
@@ -2,35 +2,491 @@
 #include "core/blob.h"
 #include "core/kernel.h"
 #include "core/graph.h"
-#include "core/kernel.h"
+#include "core/graph_instance.h"
+#include "core/profiler.h"
+#include "core/thread_pool.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <sys/mman.h>
 namespace infini
 {
     void NativeCpuRuntimeObj::run(const Graph &graph) const
     {
+        if (profiling ||
+            (interOpParallel && pool && graph->getOperators().size() > 1))
+            return run(compile(graph));
+
         const auto &kernelRegistry = KernelRegistry::getInstance();
 
         for (auto &op : graph->getOperators())
         {
             auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
-            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
-            kernel->compute(op, this);
+            auto &record = kernelRegistry.getKernelItems(
+                kernelAttrs)[selectKernel(op)];
+            std::get<0>(record)->compute(op, this);
+        }
+    }
+
+    size_t NativeCpuRuntimeObj::selectKernel(const Operator &op) const
+    {
+        if (!kernelTuning)
+            return 0;
+        return tuneKernel(op);
+    }
+
+    // times of each kernel candidate, the fastest one counts
+    static constexpr int tuningRuns = 5;
+
+    size_t NativeCpuRuntimeObj::tuneKernel(const Operator &op) const
+    {
+        auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
+        auto &records = KernelRegistry::getInstance().getKernelItems(kernelAttrs);
+        if (records.size() == 1)
+            return 0;
+
+        vector<int64_t> signature{op->getOpType().underlying(),
+                                  op->getDType().getIndex()};
+        // variants measured on other attributes solve another problem
+        auto attrs = op->getOpAttrVector();
+        signature.emplace_back(attrs.size());
+        signature.insert(signature.end(), attrs.begin(), attrs.end());
+        TensorVec tensors = op->getInputs();
+        for (auto &output : op->getOutputs())
+            tensors.emplace_back(output);
+        for (auto &tensor : tensors)
+        {
+            signature.emplace_back(tensor->getRank());
+            for (auto d : tensor->getDims())
+                signature.emplace_back(d);
+        }
+
+        std::lock_guard<std::mutex> lock(tunedKernelsMutex);
+        auto it = tunedKernels.find(signature);
+        if (it != tunedKernels.end())
+            return it->second;
+
+        // the candidates run on copies, so an output sharing memory with an
+        // input does not change the data of the graph
+        static constexpr size_t align = 64;
+        vector<size_t> offsets;
+        size_t size = 0;
+        for (auto &tensor : tensors)
+        {
+            offsets.emplace_back(size);
+            size += (tensor->getBytes() + align - 1) / align * align;
+        }
+        vector<uint8_t> scratch(size + align);
+        auto base = reinterpret_cast<uint8_t *>(
+            (reinterpret_cast<uintptr_t>(scratch.data()) + align - 1) / align *
+            align);
+        vector<Blob> blobs;
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            auto &tensor = tensors[i];
+            blobs.emplace_back(tensor->getDataBlob());
+            if (blobs.back())
+                std::memcpy(base + offsets[i],
+                            tensor->getRawDataPtr<void *>(),
+                            tensor->getBytes());
+            tensor->setDataBlob(
+                make_ref<BlobObj>(tensor->getRuntime(), base + offsets[i]));
+        }
+
+        size_t best = 0;
+        double bestTime = std::numeric_limits<double>::max();
+        for (size_t k = 0; k < records.size(); ++k)
+        {
+            auto launch = std::get<0>(records[k])->prepare(op, this);
+            // warm up
+            launch();
+            double time = std::numeric_limits<double>::max();
+            for (int r = 0; r < tuningRuns; ++r)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                launch();
+                auto end = std::chrono::steady_clock::now();
+                time = std::min(
+                    time, std::chrono::duration<double>(end - begin).count());
+            }
+            if (time < bestTime)
+            {
+                best = k;
+                bestTime = time;
+            }
+        }
+
+        for (size_t i = 0; i < tensors.size(); ++i)
+            tensors[i]->setDataBlob(blobs[i]);
+        tunedKernels.emplace(std::move(signature), best);
+        return best;
+    }
+
+    size_t NativeCpuRuntimeObj::getTunedKernelCount() const
+    {
+        std::lock_guard<std::mutex> lock(tunedKernelsMutex);
+        return tunedKernels.size();
+    }
+
+    void NativeCpuRuntimeObj::clearTunedKernels()
+    {
+        std::lock_guard<std::mutex> lock(tunedKernelsMutex);
+        tunedKernels.clear();
+    }
+
+    // Successors of every operator of a topologically sorted list. Besides the
+    // data edges, an operator writing memory that an earlier tensor occupies
+    // (reused after the tensor died, or shared in place) must wait for every
+    // earlier operator using that tensor.
+    static vector<vector<size_t>> getSuccessors(const OpVec &ops,
+                                                const TensorVec &tensors)
+    {
+        std::unordered_map<OperatorObj *, size_t> index;
+        for (size_t i = 0; i < ops.size(); ++i)
+            index.emplace(ops[i].get(), i);
+
+        struct Range
+        {
+            uintptr_t begin, end;
+            TensorObj *tensor;
+        };
+        vector<Range> ranges;
+        size_t maxBytes = 0;
+        for (auto &tensor : tensors)
+        {
+            if (tensor->getBytes() == 0)
+                continue;
+            auto begin = reinterpret_cast<uintptr_t>(
+                tensor->getRawDataPtr<void *>());
+            ranges.push_back({begin, begin + tensor->getBytes(), tensor.get()});
+            maxBytes = std::max(maxBytes, tensor->getBytes());
+        }
+        std::sort(ranges.begin(), ranges.end(),
+                  [](const Range &a, const Range &b)
+                  { return a.begin < b.begin; });
+
+        auto users = [&](TensorObj *tensor)
+        {
+            vector<size_t> result;
+            if (auto source = tensor->getSource())
+                result.push_back(index.at(source.get()));
+            for (auto &target : tensor->getTargets())
+                result.push_back(index.at(target.get()));
+            return result;
+        };
+
+        vector<vector<size_t>> successors(ops.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            for (auto &input : ops[i]->getInputs())
+                if (auto source = input->getSource())
+                    successors[index.at(source.get())].push_back(i);
+            for (auto &output : ops[i]->getOutputs())
+            {
+                if (output->getBytes() == 0)
+                    continue;
+                auto begin = reinterpret_cast<uintptr_t>(
+                    output->getRawDataPtr<void *>());
+                auto end = begin + output->getBytes();
+                // ranges overlapping [begin, end) start in
+                // (begin - maxBytes, end)
+                auto it = std::upper_bound(
+                    ranges.begin(), ranges.end(),
+                    begin > maxBytes ? begin - maxBytes : 0,
+                    [](uintptr_t v, const Range &r)
+                    { return v < r.begin; });
+                for (; it != ranges.end() && it->begin < end; ++it)
+                {
+                    if (it->end <= begin || it->tensor == output.get())
+                        continue;
+                    for (auto user : users(it->tensor))
+                        if (user < i)
+                            successors[user].push_back(i);
+                }
+            }
+        }
+        for (auto &s : successors)
+        {
+            std::sort(s.begin(), s.end());
+            s.erase(std::unique(s.begin(), s.end()), s.end());
+        }
+        return successors;
+    }
+
+    ExecutionPlan NativeCpuRuntimeObj::compile(const Graph &graph) const
+    {
+        const auto &kernelRegistry = KernelRegistry::getInstance();
+
+        ExecutionPlan plan;
+        plan.ops = graph->getOperators();
+        for (auto &op : plan.ops)
+        {
+            auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
+            auto &record = kernelRegistry.getKernelItems(
+                kernelAttrs)[selectKernel(op)];
+            plan.launches.push_back(std::get<0>(record)->prepare(op, this));
+            plan.kernels.push_back(std::get<1>(record));
         }
+        plan.successors = getSuccessors(plan.ops, graph->getTensors());
+        return plan;
+    }
+
+    void NativeCpuRuntimeObj::run(const ExecutionPlan &plan) const
+    {
+        if (interOpParallel && pool && plan.launches.size() > 1)
+            return runParallel(plan);
+
+        for (size_t i = 0; i < plan.launches.size(); ++i)
+            launch(plan, i);
+    }
+
+    void NativeCpuRuntimeObj::launch(const ExecutionPlan &plan,
+                                     size_t idx) const
+    {
+        if (!profiling)
+            return plan.launches[idx]();
+
+        auto begin = profiler->now();
+        plan.launches[idx]();
+        auto end = profiler->now();
+
+        auto &op = plan.ops[idx];
+        Profiler::Record record{op->getGuid(), op->getOpType(), {}, {},
+                                plan.kernels[idx], begin, end - begin,
+                                std::this_thread::get_id()};
+        for (auto &input : op->getInputs())
+            record.inputs.push_back(input->getDims());
+        for (auto &output : op->getOutputs())
+            record.outputs.push_back(output->getDims());
+        profiler->add(std::move(record));
+    }
+
+    void NativeCpuRuntimeObj::runParallel(const ExecutionPlan &plan) const
+    {
+        const auto &launches = plan.launches;
+        const auto &successors = plan.successors;
+
+        // number of unfinished predecessors of every operator
+        vector<std::atomic<size_t>> pending(launches.size());
+        for (auto &s : successors)
+            for (auto succ : s)
+                ++pending[succ];
+
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t finished = 0;
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+
+        std::function<void(size_t)> execute = [&](size_t idx)
+        {
+            // the captures live on the stack of runParallel, the loop only
+            // reads locals once its operator is counted
+            const size_t n = launches.size();
+            // a ready successor continues on this thread, the others are
+            // submitted to the pool
+            while (idx < n)
+            {
+                // after a failure the remaining operators are only drained
+                if (!failed)
+                {
+                    try
+                    {
+                        launch(plan, idx);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error)
+                            error = std::current_exception();
+                        failed = true;
+                    }
+                }
+                size_t next = n;
+                for (auto succ : successors[idx])
+                {
+                    if (--pending[succ] != 0)
+                        continue;
+                    if (next == n)
+                        next = succ;
+                    else
+                        pool->submit([&execute, succ]
+                                            { execute(succ); });
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    // nothing on the stack of runParallel may be touched
+                    // once the last operator is counted
+                    if (++finished == n)
+                    {
+                        done.notify_one();
+                        return;
+                    }
+                }
+                // without a successor to run, another worker may count the
+                // last operator from now on, so leave on locals only
+                if (next == n)
+                    return;
+                idx = next;
+            }
+        };
+
+        // the roots are collected first, the counters change once they run
+        vector<size_t> roots;
+        for (size_t i = 0; i < launches.size(); ++i)
+            if (pending[i] == 0)
+                roots.push_back(i);
+        for (auto root : roots)
+            pool->submit([&execute, root]
+                                { execute(root); });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]
+                  { return finished == launches.size(); });
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void NativeCpuRuntimeObj::setNumThreads(size_t numThreads, bool pinThreads)
+    {
+        IT_ASSERT(numThreads > 0, "Number of threads must be positive");
+        pool = numThreads > 1 ? make_ref<ThreadPool>(numThreads, pinThreads)
+                              : nullptr;
+    }
+
+    size_t NativeCpuRuntimeObj::getNumThreads() const
+    {
+        return pool ? pool->size() : 1;
+    }
+
+    void NativeCpuRuntimeObj::parallelFor(
+        size_t n, FunctionRef<void(size_t, size_t)> body,
+        size_t grain) const
+    {
+        if (!pool)
+            return RuntimeObj::parallelFor(n, body, grain);
+        pool->parallelFor(n, grain, body);
     }
 
     string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
 
+    static constexpr size_t hugePageSize = 2 << 20;
+
+    void NativeCpuRuntimeObj::setAllocMode(CpuAllocMode mode, size_t alignment)
+    {
+        IT_ASSERT(alignment >= sizeof(void *) &&
+                      (alignment & (alignment - 1)) == 0,
+                  "Alignment must be a power of two, got " +
+                      std::to_string(alignment));
+        this->allocMode = mode;
+        this->alignment = alignment;
+    }
+
     void NativeCpuRuntimeObj::dealloc(void *ptr)
     {
+        {
+            std::lock_guard<std::mutex> lock(mappingsMutex);
+            auto it = mappings.find(ptr);
+            if (it != mappings.end())
+            {
+                munmap(ptr, it->second);
+                mappings.erase(it);
+                return;
+            }
+        }
         return free(ptr);
     }
 
     void *NativeCpuRuntimeObj::alloc(size_t size)
     {
-        return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
-                      sizeof(uint64_t));
+        switch (allocMode)
+        {
+        case CpuAllocMode::Zeroed:
+            return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
+                          sizeof(uint64_t));
+        case CpuAllocMode::Aligned:
+        {
+            // aligned_alloc requires the size to be a multiple of alignment
+            size = std::max((size + alignment - 1) / alignment * alignment,
+                            alignment);
+            void *ptr = std::aligned_alloc(alignment, size);
+            IT_ASSERT(ptr != nullptr, "Failed to allocate " +
+                                          std::to_string(size) + " bytes");
+            return ptr;
+        }
+        case CpuAllocMode::HugePage:
+        {
+            size = std::max((size + hugePageSize - 1) / hugePageSize *
+                                hugePageSize,
+                            hugePageSize);
+            // map one more huge page to align the start to a huge page, the
+            // unused head and tail are returned right away
+            size_t length = size + hugePageSize;
+            void *map = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            IT_ASSERT(map != MAP_FAILED, "Failed to map " +
+                                             std::to_string(length) + " bytes");
+            auto begin = reinterpret_cast<uintptr_t>(map);
+            auto aligned = (begin + hugePageSize - 1) / hugePageSize *
+                           hugePageSize;
+            if (aligned > begin)
+                munmap(map, aligned - begin);
+            if (begin + length > aligned + size)
+                munmap(reinterpret_cast<void *>(aligned + size),
+                       begin + length - aligned - size);
+            void *ptr = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+            // only a hint, the memory stays usable if THP is disabled
+            madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+            std::lock_guard<std::mutex> lock(mappingsMutex);
+            mappings.emplace(ptr, size);
+            return ptr;
+        }
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    void NativeCpuRuntimeObj::setProfiling(bool enabled)
+    {
+        if (enabled && !profiling)
+            profiler = make_ref<Profiler>();
+        profiling = enabled;
+    }
+
+    std::future<void> NativeCpuRuntimeObj::runAsync(
+        const Ref<GraphInstance> &instance)
+    {
+        IT_ASSERT(instance->getGraph()->getRuntime().get() == this,
+                  "Instance of a graph on another runtime");
+        {
+            std::lock_guard<std::mutex> lock(requestPoolMutex);
+            if (!requestPool)
+                requestPool = make_ref<ThreadPool>(
+                    requestThreads
+                        ? requestThreads
+                        : std::max(1u, std::thread::hardware_concurrency()));
+        }
+        auto task = std::make_shared<std::packaged_task<void()>>(
+            [this, instance]
+            { run(instance->getPlan()); });
+        auto future = task->get_future();
+        requestPool->submit([task]
+                            { (*task)(); });
+        return future;
+    }
+
+    void NativeCpuRuntimeObj::setRequestThreads(size_t numThreads)
+    {
+        IT_ASSERT(numThreads > 0, "Number of threads must be positive");
+        std::lock_guard<std::mutex> lock(requestPoolMutex);
+        IT_ASSERT(!requestPool, "Request pool already started");
+        requestThreads = numThreads;
     }
 
 } // namespace infini
@@ -0,0 +1,89 @@
+#include "core/stream.h"
+#include <cstring>
+#include <future>
+
+namespace infini
+{
+    Stream::Stream(const Graph &graph, size_t depth)
+        : graph(graph),
+          runtime(as<NativeCpuRuntimeObj>(graph->getRuntime())), worker(1)
+    {
+        IT_ASSERT(runtime != nullptr, "Streams run on the CPU runtime");
+        IT_ASSERT(depth > 0);
+        for (auto &tensor : graph->getInputs())
+            if (!tensor->isConstant())
+                inputs.emplace_back(tensor);
+
+        auto outputs = graph->getOutputs();
+        for (size_t i = 0; i < depth; ++i)
+        {
+            Arena arena;
+            arena.instance = make_ref<GraphInstance>(graph);
+            for (auto &tensor : inputs)
+                arena.inputs.emplace_back(
+                    arena.instance->getRawDataPtr<void *>(tensor));
+            for (auto &tensor : outputs)
+                arena.outputs.emplace_back(
+                    arena.instance->getRawDataPtr<void *>(tensor));
+            arenas.emplace_back(std::move(arena));
+        }
+    }
+
+    void Stream::stage(const Request &request, Arena &arena) const
+    {
+        IT_ASSERT(request.size() == inputs.size(),
+                  "Expected " + std::to_string(inputs.size()) +
+                      " inputs per request, got " +
+                      std::to_string(request.size()));
+        for (size_t i = 0; i < inputs.size(); ++i)
+            std::memcpy(arena.inputs[i], request[i], inputs[i]->getBytes());
+    }
+
+    void Stream::run(const vector<Request> &requests, const Callback &callback)
+    {
+        auto depth = arenas.size();
+        auto launch = [&](size_t i)
+        {
+            auto task = std::make_shared<std::packaged_task<void()>>(
+                [this, &instance = *arenas[i % depth].instance]
+                { runtime->run(instance.getPlan()); });
+            auto future = task->get_future();
+            worker.submit([task]
+                          { (*task)(); });
+            return future;
+        };
+
+        if (requests.empty())
+            return;
+        // the arenas of the first requests are free
+        for (size_t i = 0; i < std::min(depth, requests.size()); ++i)
+            stage(requests[i], arenas[i]);
+        auto computing = launch(0);
+        try
+        {
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                computing.get();
+                // with a single arena the next request is staged only after
+                // the outputs are read
+                bool overlap = depth > 1;
+                if (overlap && i + 1 < requests.size())
+                    computing = launch(i + 1);
+                callback(i, arenas[i % depth].outputs);
+                // the arena of request i is free once its outputs are read
+                if (i + depth < requests.size())
+                    stage(requests[i + depth], arenas[i % depth]);
+                if (!overlap && i + 1 < requests.size())
+                    computing = launch(i + 1);
+            }
+        }
+        catch (...)
+        {
+            // the arenas must not be in use when run returns
+            if (computing.valid())
+                computing.wait();
+            throw;
+        }
+    }
+
+} // namespace infini
@@ -0,0 +1,143 @@
+#include "core/thread_pool.h"
+#include <atomic>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace infini
+{
+    ThreadPool::ThreadPool(size_t numThreads, bool pinThreads)
+    {
+        IT_ASSERT(numThreads > 0);
+#ifdef __linux__
+        // the CPUs the process may run on, which taskset or a cgroup cpuset
+        // may restrict to any subset
+        vector<int> cpus;
+        if (pinThreads)
+        {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                    if (CPU_ISSET(cpu, &allowed))
+                        cpus.push_back(cpu);
+        }
+#endif
+        workers.reserve(numThreads);
+        for (size_t i = 0; i < numThreads; ++i)
+        {
+            workers.emplace_back([this]
+                                 { work(); });
+#ifdef __linux__
+            if (!cpus.empty())
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.size()], &set);
+                // pinning is best effort, e.g. cores may be reserved
+                pthread_setaffinity_np(workers.back().native_handle(),
+                                       sizeof(set), &set);
+            }
+#endif
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    void ThreadPool::parallelFor(size_t n, size_t grain,
+                                 FunctionRef<void(size_t, size_t)> body)
+    {
+        grain = std::max(grain, size_t(1));
+        // one chunk per worker and one for the caller at most
+        size_t chunks = std::min((n + grain - 1) / grain, workers.size() + 1);
+        if (chunks <= 1)
+        {
+            if (n > 0)
+                body(0, n);
+            return;
+        }
+
+        // shared with the helpers, which may start after parallelFor returns
+        struct State
+        {
+            std::atomic<size_t> next{0};
+            size_t done = 0;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+        auto state = std::make_shared<State>();
+        auto chunkSize = (n + chunks - 1) / chunks;
+        // runs chunks until none is left, `body` is only used while a chunk
+        // is not done
+        auto runChunks = [state, chunks, chunkSize, n, body]
+        {
+            size_t chunk;
+            while ((chunk = state->next++) < chunks)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    body(chunk * chunkSize, std::min(n, (chunk + 1) * chunkSize));
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (error && !state->error)
+                    state->error = error;
+                if (++state->done == chunks)
+                    state->cv.notify_one();
+            }
+        };
+        for (size_t i = 1; i < chunks; ++i)
+            submit(runChunks);
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&]
+                       { return state->done == chunks; });
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+
+    void ThreadPool::work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]
+                        { return stop || !tasks.empty(); });
+                // pending tasks are still run when stopping
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+} // namespace infini
@@ -1,11 +1,16 @@
 #include "operators/concat.h"
 #include "core/kernel.h"
+#include <cstring>
 
 namespace infini {
 
 class NaiveConcat : public CpuKernelWithoutConfig {
+    // runs shorter than this are copied element by element
+    static constexpr size_t shortRun = 16;
+
     template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
+    std::function<void()> doPrepare(const Operator &_op,
+                                    const RuntimeObj *context) const {
         auto op = as<ConcatObj>(_op);
         auto inputs = op->getInputs(), outputs = op->getOutputs();
         auto dim = op->getDim();
@@ -14,10 +19,25 @@ class NaiveConcat : public CpuKernelWithoutConfig {
         for (auto input : inputs)
             iDims.emplace_back(input->getDims());
         const auto &outDim = output->getDims();
+        size_t n = output->size();
+        if (n == 0)
+            return [] {};
         size_t blockOffsetInner = 1;
         for (size_t i = outDim.size() - 1; i > (size_t)dim; --i)
             blockOffsetInner *= outDim[i];
         size_t blockOffset = outDim[dim] * blockOffsetInner;
+        size_t outer = n / blockOffset;
+
+        // Every block of the output, one per outer index, is the
+        // concatenation of one contiguous run of each input
+        struct Segment {
+            // null if the input is in place already
+            T *inPtr;
+            // offset in the block and length of the runs
+            size_t begin, size;
+        };
+        std::vector<Segment> segments;
+        auto outPtr = output->getRawDataPtr<T *>();
         for (size_t i = 0; i < inputs.size(); ++i) {
             auto input = inputs[i];
             auto dimOffset = 0;
@@ -29,30 +49,85 @@ class NaiveConcat : public CpuKernelWithoutConfig {
                  i >= (size_t)dim && i != (size_t)-1; --i)
                 localBlockOffset *= iDim[i];
             auto innerOffset = blockOffsetInner * dimOffset;
-            auto inSize = input->size();
-            auto inPtr = input->getRawDataPtr<T *>(),
-                 outPtr = output->getRawDataPtr<T *>();
-#pragma omp parallel for
-            for (size_t iOffset = 0; iOffset < inSize; ++iOffset) {
-                auto oOffset = iOffset % localBlockOffset + innerOffset +
-                               iOffset / localBlockOffset * blockOffset;
-                outPtr[oOffset] = inPtr[iOffset];
-            }
+            auto inPtr = input->getRawDataPtr<T *>();
+            // the memory planner may have placed the input as a slice of the
+            // output already
+            if (outer == 1 && inPtr == outPtr + innerOffset)
+                inPtr = nullptr;
+            segments.push_back({inPtr, innerOffset, localBlockOffset});
         }
+        if (std::all_of(segments.begin(), segments.end(),
+                        [](const Segment &seg) { return seg.size < shortRun; }))
+            // concat on the innermost axes, where a call per run would cost
+            // more than the copy: whole blocks, a short loop per input
+            return [=] {
+                context->parallelFor(
+                    outer,
+                    [&](size_t begin, size_t end) {
+                        for (size_t o = begin; o < end; ++o)
+                            for (const auto &seg : segments) {
+                                if (!seg.inPtr)
+                                    continue;
+                                const T *in = seg.inPtr + o * seg.size;
+                                T *out = outPtr + o * blockOffset + seg.begin;
+                                for (size_t k = 0; k < seg.size; ++k)
+                                    out[k] = in[k];
+                            }
+                    },
+                    std::max<size_t>(1, elementGrain / blockOffset));
+            };
+
+        return [=] {
+            // chunks of the output, copied run by run
+            context->parallelFor(
+                n,
+                [&](size_t begin, size_t end) {
+                    size_t o = begin / blockOffset, pos = begin % blockOffset;
+                    auto after = [](size_t pos, const Segment &seg) {
+                        return pos < seg.begin;
+                    };
+                    size_t s = std::upper_bound(segments.begin(),
+                                                segments.end(), pos, after) -
+                               segments.begin() - 1;
+                    for (size_t i = begin; i < end;) {
+                        const auto &seg = segments[s];
+                        size_t from = pos - seg.begin;
+                        size_t len = std::min(seg.size - from, end - i);
+                        if (seg.inPtr)
+                            std::memcpy(outPtr + i,
+                                        seg.inPtr + o * seg.size + from,
+                                        len * sizeof(T));
+                        i += len;
+                        pos += len;
+                        if (pos < seg.begin + seg.size)
+                            continue;
+                        // next input, or the first of the next block
+                        if (++s == segments.size()) {
+                            s = 0;
+                            pos = 0;
+                            ++o;
+                        }
+                    }
+                },
+                elementGrain);
+        };
     }
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
+        prepare(_op, context)();
+    }
+
+    std::function<void()> prepare(const Operator &_op,
+                                  const RuntimeObj *context) const override {
 #define CASE(N)                                                                \
     case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
         int dataTypeIdx = _op->getDType().getIndex();
         switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
+            CASE(1);  // DataType::Float32
             CASE(12); // DataType::UInt32
-            break;
         default:
             IT_TODO_HALT();
         }
@@ -1,11 +1,16 @@
 #include "operators/element_wise.h"
 #include "core/kernel.h"
 #include "utils/operator_utils.h"
+#include "utils/simd.h"
 
 namespace infini
 {
     class NativeElementWise : public CpuKernelWithoutConfig
     {
+        // rank left after merging dimensions up to which the odometer of a
+        // launch lives on the stack, higher ones allocate it
+        static constexpr size_t maxRank = 8;
+
         template <typename T>
         static T addCompute(T val0, T val1)
         {
@@ -30,90 +35,187 @@ namespace infini
             return (T)(val0 / val1);
         }
 
-        template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        // c[i] = op(a[i * strideA], b[i * strideB]) for i in [0, n), with
+        // strides of 0 or 1; the branches keep every loop contiguous
+        template <typename T, T (*op)(T, T)>
+        static void computeRow(const T *a, size_t strideA, const T *b,
+                               size_t strideB, T *c, size_t n)
         {
-            auto op = as<ElementWiseObj>(_op);
-            T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
-            T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            if (strideA && strideB)
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = op(a[i], b[i]);
+            else if (strideA)
+            {
+                T y = *b;
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = op(a[i], y);
+            }
+            else
+            {
+                T x = *a;
+                for (size_t i = 0; i < n; ++i)
+                    c[i] = op(x, b[i]);
+            }
+        }
 
-            auto shapeA = op->getInputs(0)->getDims();
-            auto shapeB = op->getInputs(1)->getDims();
-            auto shapeC = op->getOutput()->getDims();
-            auto rank = op->getOutput()->getRank();
-            Shape a(rank, 1);
-            Shape b(rank, 1);
-            std::copy(shapeA.begin(), shapeA.end(),
-                      a.begin() + (rank - shapeA.size()));
-            std::copy(shapeB.begin(), shapeB.end(),
-                      b.begin() + (rank - shapeB.size()));
-            auto getStride = [&](const Shape &shape)
+        // simdRow replaces computeRow on the CPUs that have it
+        template <typename T, T (*op)(T, T)>
+        std::function<void()>
+        doPrepare(const Operator &_op, const RuntimeObj *context,
+                  typename SimdOps<T>::Binary simdRow) const
+        {
+            T *inptr0 = _op->getInputs(0)->getRawDataPtr<T *>();
+            T *inptr1 = _op->getInputs(1)->getRawDataPtr<T *>();
+            T *outptr = _op->getOutput()->getRawDataPtr<T *>();
+
+            auto shapeA = _op->getInputs(0)->getDims();
+            auto shapeB = _op->getInputs(1)->getDims();
+            auto shapeC = _op->getOutput()->getDims();
+            auto rank = shapeC.size();
+            shapeA.insert(shapeA.begin(), rank - shapeA.size(), 1);
+            shapeB.insert(shapeB.begin(), rank - shapeB.size(), 1);
+
+            // Drops the dimensions of size 1 and merges adjacent ones that
+            // both inputs either broadcast or not, so identical shapes become
+            // a single dimension, and row or column broadcasts two.
+            vector<size_t> dims;
+            vector<bool> broadcastA, broadcastB;
+            for (size_t d = 0; d < rank; ++d)
             {
-                int p = 1;
-                Shape stride(rank);
-                for (auto i = rank; i > 0; --i)
+                if (shapeC[d] == 1)
+                    continue;
+                bool bcA = shapeA[d] == 1, bcB = shapeB[d] == 1;
+                if (!dims.empty() && broadcastA.back() == bcA &&
+                    broadcastB.back() == bcB)
+                    dims.back() *= shapeC[d];
+                else
                 {
-                    stride[i - 1] = p;
-                    p = p * shape[i - 1];
+                    dims.push_back(shapeC[d]);
+                    broadcastA.push_back(bcA);
+                    broadcastB.push_back(bcB);
                 }
-                return stride;
+            }
+            if (dims.empty())
+            {
+                dims.push_back(1);
+                broadcastA.push_back(false);
+                broadcastB.push_back(false);
+            }
+            // broadcast dimensions get a stride of 0
+            auto r = dims.size();
+            vector<size_t> strideA(r), strideB(r);
+            for (size_t d = r, pA = 1, pB = 1; d > 0; --d)
+            {
+                strideA[d - 1] = broadcastA[d - 1] ? 0 : pA;
+                strideB[d - 1] = broadcastB[d - 1] ? 0 : pB;
+                pA *= broadcastA[d - 1] ? 1 : dims[d - 1];
+                pB *= broadcastB[d - 1] ? 1 : dims[d - 1];
+            }
+
+            auto n = _op->getOutput()->size();
+            return [=]
+            {
+                context->parallelFor(
+                    n,
+                    [&](size_t begin, size_t end)
+                    {
+                        // Walks the rows of the innermost dimension, the
+                        // offsets of the outer ones advance like an odometer
+                        size_t inner = dims[r - 1];
+                        size_t col = begin % inner, rest = begin / inner;
+                        size_t offA = col * strideA[r - 1],
+                               offB = col * strideB[r - 1];
+                        size_t stackPos[maxRank];
+                        vector<size_t> heapPos(r > maxRank ? r - 1 : 0);
+                        size_t *pos = r > maxRank ? heapPos.data() : stackPos;
+                        for (size_t d = r - 1; d > 0; --d)
+                        {
+                            pos[d - 1] = rest % dims[d - 1];
+                            rest /= dims[d - 1];
+                            offA += pos[d - 1] * strideA[d - 1];
+                            offB += pos[d - 1] * strideB[d - 1];
+                        }
+                        for (size_t i = begin; i < end; col = 0)
+                        {
+                            size_t len = std::min(inner - col, end - i);
+                            if (simdRow)
+                                simdRow(inptr0 + offA, strideA[r - 1],
+                                        inptr1 + offB, strideB[r - 1],
+                                        outptr + i, len);
+                            else
+                                computeRow<T, op>(
+                                    inptr0 + offA, strideA[r - 1],
+                                    inptr1 + offB, strideB[r - 1],
+                                    outptr + i, len);
+                            i += len;
+                            offA -= col * strideA[r - 1];
+                            offB -= col * strideB[r - 1];
+                            for (size_t d = r - 1; d > 0; --d)
+                            {
+                                offA += strideA[d - 1];
+                                offB += strideB[d - 1];
+                                if (++pos[d - 1] < dims[d - 1])
+                                    break;
+                                offA -= strideA[d - 1] * dims[d - 1];
+                                offB -= strideB[d - 1] * dims[d - 1];
+                                pos[d - 1] = 0;
+                            }
+                        }
+                    },
+                    elementGrain);
             };
-            Shape strideA = getStride(a);
-            Shape strideB = getStride(b);
+        }
 
-            auto n = op->getOutput()->size();
-            T (*_doCompute)
-            (T val0, T val1);
-            switch (op->getOpType().underlying())
+        template <typename T>
+        std::function<void()> doPrepare(const Operator &_op,
+                                        const RuntimeObj *context) const
+        {
+            const auto &simd = getSimdOps<T>();
+            switch (_op->getOpType().underlying())
             {
             case OpType::Add:
-                _doCompute = addCompute<T>;
-                break;
+                return doPrepare<T, addCompute<T>>(_op, context, simd.add);
             case OpType::Sub:
-                _doCompute = subCompute<T>;
-                break;
+                return doPrepare<T, subCompute<T>>(_op, context, simd.sub);
             case OpType::Mul:
-                _doCompute = mulCompute<T>;
-                break;
+                return doPrepare<T, mulCompute<T>>(_op, context, simd.mul);
             case OpType::Div:
-                _doCompute = divCompute<T>;
-                break;
+                return doPrepare<T, divCompute<T>>(_op, context, simd.div);
             default:
                 IT_TODO_HALT();
             }
-
-            for (size_t i = 0; i < n; ++i)
-            {
-                auto shapeIndexC = locate_index(i, shapeC);
-                auto indexA = delocate_index(shapeIndexC, a, strideA);
-                auto indexB = delocate_index(shapeIndexC, b, strideB);
-                outptr[i] = _doCompute(inptr0[indexA], inptr1[indexB]);
-            }
         }
 
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
+            prepare(_op, context)();
+        }
+
+        std::function<void()> prepare(const Operator &_op,
+                                      const RuntimeObj *context) const override
+        {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
             default:
                 IT_TODO_HALT();
             }
         }
     };
 
-    REGISTER_KERNEL(Device::CPU, OpType::Add, NativeElementWise, "addNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Sub, NativeElementWise, "subNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Mul, NativeElementWise, "mulNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Div, NativeElementWise, "divNaive_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Add, NativeElementWise,
+                            "addNaive_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Sub, NativeElementWise,
+                            "subNaive_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Mul, NativeElementWise,
+                            "mulNaive_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Div, NativeElementWise,
+                            "divNaive_CPU");
 }; // namespace infini
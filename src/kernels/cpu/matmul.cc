@@ -0,0 +1,210 @@
+#include "operators/matmul.h"
+#include "core/kernel.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    /**
+     * @brief Blocked GEMM. The output is split into MC x NC tiles, which are
+     * computed in parallel together with the batches. For every KC-deep slice
+     * of a tile, A and B are packed into contiguous panels of MR rows and NR
+     * columns, and a register-blocked micro-kernel computes MR x NR blocks of
+     * the tile from them. The transposes are handled by the packing, which
+     * reads the inputs through strides.
+     */
+    class NativeMatmul : public CpuKernelWithoutConfig
+    {
+        // micro-kernel block, its accumulators fit in the vector registers and
+        // the NR contiguous lanes vectorize
+        static constexpr size_t MR = 4, NR = 8;
+        // cache blocks: an A panel stays in L1, the packed A block in L2
+        static constexpr size_t MC = 96, NC = 256, KC = 256;
+
+        // element (i, j) of a matrix is at ptr[i * rowStride + j * colStride]
+        template <typename T>
+        struct Matrix
+        {
+            const T *ptr;
+            size_t rowStride, colStride;
+        };
+
+        // Packs rows [0, mc) x cols [0, kc) of A into panels of MR rows, each
+        // stored column by column. Rows past mc are zero.
+        template <typename T>
+        static void packA(const Matrix<T> &a, size_t mc, size_t kc, T *dst)
+        {
+            for (size_t i = 0; i < mc; i += MR)
+            {
+                size_t mr = std::min(MR, mc - i);
+                for (size_t p = 0; p < kc; ++p, dst += MR)
+                {
+                    const T *src = a.ptr + i * a.rowStride + p * a.colStride;
+                    for (size_t r = 0; r < mr; ++r)
+                        dst[r] = src[r * a.rowStride];
+                    std::fill(dst + mr, dst + MR, T(0));
+                }
+            }
+        }
+
+        // Packs rows [0, kc) x cols [0, nc) of B into panels of NR columns,
+        // each stored row by row. Columns past nc are zero.
+        template <typename T>
+        static void packB(const Matrix<T> &b, size_t kc, size_t nc, T *dst)
+        {
+            for (size_t j = 0; j < nc; j += NR)
+            {
+                size_t nr = std::min(NR, nc - j);
+                for (size_t p = 0; p < kc; ++p, dst += NR)
+                {
+                    const T *src = b.ptr + p * b.rowStride + j * b.colStride;
+                    for (size_t c = 0; c < nr; ++c)
+                        dst[c] = src[c * b.colStride];
+                    std::fill(dst + nr, dst + NR, T(0));
+                }
+            }
+        }
+
+        // C[0, mr) x [0, nr) (+)= packed A panel x packed B panel
+        template <typename T>
+        static void microKernel(size_t kc, const T *a, const T *b, T *c,
+                                size_t ldc, size_t mr, size_t nr,
+                                bool accumulate)
+        {
+            T acc[MR][NR] = {};
+            for (size_t p = 0; p < kc; ++p, a += MR, b += NR)
+                for (size_t i = 0; i < MR; ++i)
+                    for (size_t j = 0; j < NR; ++j)
+                        acc[i][j] += a[i] * b[j];
+            for (size_t i = 0; i < mr; ++i)
+                for (size_t j = 0; j < nr; ++j)
+                    c[i * ldc + j] =
+                        accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+        }
+
+        // C[mc x nc] = A[mc x k] x B[k x nc], row-major C with leading
+        // dimension ldc
+        template <typename T>
+        static void computeTile(Matrix<T> a, Matrix<T> b, T *c, size_t ldc,
+                                size_t mc, size_t nc, size_t k)
+        {
+            if (k == 0)
+            {
+                for (size_t i = 0; i < mc; ++i)
+                    std::fill(c + i * ldc, c + i * ldc + nc, T(0));
+                return;
+            }
+            // reused by the tiles a thread computes
+            thread_local vector<T> packedA, packedB;
+            packedA.resize(MC * KC);
+            packedB.resize(KC * NC);
+            for (size_t pc = 0; pc < k; pc += KC)
+            {
+                size_t kc = std::min(KC, k - pc);
+                packA(Matrix<T>{a.ptr + pc * a.colStride, a.rowStride,
+                                a.colStride},
+                      mc, kc, packedA.data());
+                packB(Matrix<T>{b.ptr + pc * b.rowStride, b.rowStride,
+                                b.colStride},
+                      kc, nc, packedB.data());
+                for (size_t j = 0; j < nc; j += NR)
+                    for (size_t i = 0; i < mc; i += MR)
+                        microKernel(kc, packedA.data() + i * kc,
+                                    packedB.data() + j * kc, c + i * ldc + j,
+                                    ldc, std::min(MR, mc - i),
+                                    std::min(NR, nc - j), pc > 0);
+            }
+        }
+
+        template <typename T>
+        std::function<void()> doPrepare(const Operator &_op,
+                                        const RuntimeObj *context) const
+        {
+            auto op = as<MatmulObj>(_op);
+            const T *aPtr = op->getInputs(0)->getRawDataPtr<T *>();
+            const T *bPtr = op->getInputs(1)->getRawDataPtr<T *>();
+            T *cPtr = op->getOutput()->getRawDataPtr<T *>();
+            size_t m = op->getM(), n = op->getN(), k = op->getK();
+
+            // strides of (row, col) of A and B after the transposes
+            size_t aRow = op->getTransA() ? 1 : k,
+                   aCol = op->getTransA() ? m : 1;
+            size_t bRow = op->getTransB() ? 1 : n,
+                   bCol = op->getTransB() ? k : 1;
+
+            // offsets of the matrices of A and B in every batch of C, with the
+            // broadcast batch dimensions not advancing
+            auto shapeA = op->getInputs(0)->getDims(),
+                 shapeB = op->getInputs(1)->getDims(),
+                 shapeC = op->getOutput()->getDims();
+            auto rank = shapeC.size();
+            shapeA.insert(shapeA.begin(), rank - shapeA.size(), 1);
+            shapeB.insert(shapeB.begin(), rank - shapeB.size(), 1);
+            size_t batch = std::accumulate(shapeC.begin(), shapeC.end() - 2,
+                                           size_t(1), std::multiplies<>());
+            vector<size_t> offsetA(batch), offsetB(batch);
+            for (size_t i = 0; i < batch; ++i)
+            {
+                size_t rest = i, strideA = m * k, strideB = k * n;
+                for (size_t d = rank - 2; d > 0; --d)
+                {
+                    size_t pos = rest % shapeC[d - 1];
+                    rest /= shapeC[d - 1];
+                    if (shapeA[d - 1] != 1)
+                        offsetA[i] += pos * strideA;
+                    if (shapeB[d - 1] != 1)
+                        offsetB[i] += pos * strideB;
+                    strideA *= shapeA[d - 1];
+                    strideB *= shapeB[d - 1];
+                }
+            }
+
+            size_t mTiles = (m + MC - 1) / MC, nTiles = (n + NC - 1) / NC;
+            return [=]
+            {
+                context->parallelFor(
+                    batch * mTiles * nTiles,
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t t = begin; t < end; ++t)
+                        {
+                            size_t b = t / (mTiles * nTiles),
+                                   i = t / nTiles % mTiles * MC,
+                                   j = t % nTiles * NC;
+                            computeTile(
+                                Matrix<T>{aPtr + offsetA[b] + i * aRow, aRow,
+                                          aCol},
+                                Matrix<T>{bPtr + offsetB[b] + j * bCol, bRow,
+                                          bCol},
+                                cPtr + b * m * n + i * n + j, n,
+                                std::min(MC, m - i), std::min(NC, n - j), k);
+                        }
+                    });
+            };
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+            prepare(_op, context)();
+        }
+
+        std::function<void()> prepare(const Operator &_op,
+                                      const RuntimeObj *context) const override
+        {
+#define CASE(N) \
+    case N:     \
+        return doPrepare<DT<N>::t>(_op, context)
+
+            int dataTypeIdx = _op->getDType().getIndex();
+            switch (dataTypeIdx)
+            {
+                CASE(1); // DataType::Float32
+                CASE(12); // DataType::UInt32
+            default:
+                IT_TODO_HALT();
+            }
+        }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::MatMul, NativeMatmul, "MatMul_CPU");
+}; // namespace infini
@@ -0,0 +1,157 @@
+#include "utils/simd.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Built with -mavx2 -mfma, only called after CPUID reported AVX2. Everything
+// but the exported table getter has internal linkage, so no code compiled for
+// AVX2 can be picked by the linker for the generic kernels.
+namespace infini
+{
+#ifdef __AVX2__
+    namespace
+    {
+        struct F32x8
+        {
+            using T = float;
+            using Reg = __m256;
+            static constexpr size_t width = 8;
+            static Reg load(const T *p) { return _mm256_loadu_ps(p); }
+            static void store(T *p, Reg x) { _mm256_storeu_ps(p, x); }
+            static Reg set1(T x) { return _mm256_set1_ps(x); }
+            static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+            static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+            static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+            static Reg div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+            // max_ps returns its second operand for NaN and signed zeros,
+            // like std::max(0, x)
+            static Reg relu(Reg x)
+            {
+                return _mm256_max_ps(x, _mm256_setzero_ps());
+            }
+            static Reg clip(Reg x, Reg lo, Reg hi)
+            {
+                auto r = _mm256_blendv_ps(x, hi, _mm256_cmp_ps(x, hi, _CMP_GT_OQ));
+                return _mm256_blendv_ps(r, lo, _mm256_cmp_ps(x, lo, _CMP_LT_OQ));
+            }
+        };
+
+        struct U32x8
+        {
+            using T = uint32_t;
+            using Reg = __m256i;
+            static constexpr size_t width = 8;
+            static Reg load(const T *p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const Reg *>(p));
+            }
+            static void store(T *p, Reg x)
+            {
+                _mm256_storeu_si256(reinterpret_cast<Reg *>(p), x);
+            }
+            static Reg set1(T x) { return _mm256_set1_epi32(int(x)); }
+            static Reg add(Reg a, Reg b) { return _mm256_add_epi32(a, b); }
+            static Reg sub(Reg a, Reg b) { return _mm256_sub_epi32(a, b); }
+            static Reg mul(Reg a, Reg b) { return _mm256_mullo_epi32(a, b); }
+            static Reg clip(Reg x, Reg lo, Reg hi)
+            {
+                // x >= lo where max(x, lo) == x
+                auto notBelow = _mm256_cmpeq_epi32(_mm256_max_epu32(x, lo), x);
+                return _mm256_blendv_epi8(lo, _mm256_min_epu32(x, hi), notBelow);
+            }
+        };
+
+        // In-register transpose of 32-bit lanes: unpack pairs of rows, shuffle
+        // quadruples and swap the 128-bit halves
+        template <typename T>
+        void transpose8x8(const T *src, size_t srcStride, T *dst,
+                          size_t dstStride)
+        {
+            static_assert(sizeof(T) == sizeof(float));
+            auto in = reinterpret_cast<const float *>(src);
+            auto out = reinterpret_cast<float *>(dst);
+            __m256 r[8], t[8];
+            for (int i = 0; i < 8; ++i)
+                r[i] = _mm256_loadu_ps(in + i * srcStride);
+            for (int i = 0; i < 8; i += 2)
+            {
+                t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+                t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+            }
+            for (int i = 0; i < 8; i += 4)
+            {
+                r[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            for (int i = 0; i < 4; ++i)
+            {
+                _mm256_storeu_ps(out + i * dstStride,
+                                 _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+                _mm256_storeu_ps(out + (i + 4) * dstStride,
+                                 _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+            }
+        }
+
+        const SimdOps<float> *getF32Ops()
+        {
+            static const SimdOps<float> ops = []
+            {
+                SimdOps<float> ops;
+                ops.add = simdBinaryRow<F32x8, F32x8::add>;
+                ops.sub = simdBinaryRow<F32x8, F32x8::sub>;
+                ops.mul = simdBinaryRow<F32x8, F32x8::mul>;
+                ops.div = simdBinaryRow<F32x8, F32x8::div>;
+                ops.relu = [](const float *x, float *y, size_t n)
+                {
+                    simdUnaryRow<F32x8>(x, y, n,
+                                        [](__m256 v)
+                                        { return F32x8::relu(v); });
+                };
+                ops.clip = [](const float *x, float *y, size_t n, float lo,
+                              float hi)
+                {
+                    auto l = F32x8::set1(lo), h = F32x8::set1(hi);
+                    simdUnaryRow<F32x8>(x, y, n,
+                                        [=](__m256 v)
+                                        { return F32x8::clip(v, l, h); });
+                };
+                ops.transpose8x8 = transpose8x8<float>;
+                return ops;
+            }();
+            return &ops;
+        }
+
+        // relu is a copy for unsigned data and division has no instruction,
+        // both stay with the portable loops
+        const SimdOps<uint32_t> *getU32Ops()
+        {
+            static const SimdOps<uint32_t> ops = []
+            {
+                SimdOps<uint32_t> ops;
+                ops.add = simdBinaryRow<U32x8, U32x8::add>;
+                ops.sub = simdBinaryRow<U32x8, U32x8::sub>;
+                ops.mul = simdBinaryRow<U32x8, U32x8::mul>;
+                ops.clip = [](const uint32_t *x, uint32_t *y, size_t n,
+                              uint32_t lo, uint32_t hi)
+                {
+                    auto l = U32x8::set1(lo), h = U32x8::set1(hi);
+                    simdUnaryRow<U32x8>(x, y, n,
+                                        [=](__m256i v)
+                                        { return U32x8::clip(v, l, h); });
+                };
+                ops.transpose8x8 = transpose8x8<uint32_t>;
+                return ops;
+            }();
+            return &ops;
+        }
+    } // namespace
+
+    SimdTables getAvx2Tables() { return {getF32Ops(), getU32Ops()}; }
+    bool hasAvx2Kernels() { return true; }
+#else
+    SimdTables getAvx2Tables() { return {nullptr, nullptr}; }
+    bool hasAvx2Kernels() { return false; }
+#endif
+} // namespace infini
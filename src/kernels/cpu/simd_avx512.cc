@@ -0,0 +1,126 @@
+#include "utils/simd.h"
+#ifdef __AVX512F__
+#include <immintrin.h>
+// GCC 12 takes the undefined placeholders of the masked intrinsics for
+// uninitialized reads
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Built with -mavx512f, only called after CPUID reported AVX-512. Everything
+// but the exported table getter has internal linkage, so no code compiled for
+// AVX-512 can be picked by the linker for the generic kernels.
+namespace infini
+{
+#ifdef __AVX512F__
+    namespace
+    {
+        struct F32x16
+        {
+            using T = float;
+            using Reg = __m512;
+            static constexpr size_t width = 16;
+            static Reg load(const T *p) { return _mm512_loadu_ps(p); }
+            static void store(T *p, Reg x) { _mm512_storeu_ps(p, x); }
+            static Reg set1(T x) { return _mm512_set1_ps(x); }
+            static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+            static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+            static Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+            static Reg div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+            // max_ps returns its second operand for NaN and signed zeros,
+            // like std::max(0, x)
+            static Reg relu(Reg x)
+            {
+                return _mm512_max_ps(x, _mm512_setzero_ps());
+            }
+            static Reg clip(Reg x, Reg lo, Reg hi)
+            {
+                auto r = _mm512_mask_blend_ps(
+                    _mm512_cmp_ps_mask(x, hi, _CMP_GT_OQ), x, hi);
+                return _mm512_mask_blend_ps(
+                    _mm512_cmp_ps_mask(x, lo, _CMP_LT_OQ), r, lo);
+            }
+        };
+
+        struct U32x16
+        {
+            using T = uint32_t;
+            using Reg = __m512i;
+            static constexpr size_t width = 16;
+            static Reg load(const T *p) { return _mm512_loadu_si512(p); }
+            static void store(T *p, Reg x) { _mm512_storeu_si512(p, x); }
+            static Reg set1(T x) { return _mm512_set1_epi32(int(x)); }
+            static Reg add(Reg a, Reg b) { return _mm512_add_epi32(a, b); }
+            static Reg sub(Reg a, Reg b) { return _mm512_sub_epi32(a, b); }
+            static Reg mul(Reg a, Reg b) { return _mm512_mullo_epi32(a, b); }
+            static Reg clip(Reg x, Reg lo, Reg hi)
+            {
+                return _mm512_mask_blend_epi32(_mm512_cmplt_epu32_mask(x, lo),
+                                               _mm512_min_epu32(x, hi), lo);
+            }
+        };
+
+        const SimdOps<float> *getF32Ops()
+        {
+            static const SimdOps<float> ops = []
+            {
+                SimdOps<float> ops;
+                ops.add = simdBinaryRow<F32x16, F32x16::add>;
+                ops.sub = simdBinaryRow<F32x16, F32x16::sub>;
+                ops.mul = simdBinaryRow<F32x16, F32x16::mul>;
+                ops.div = simdBinaryRow<F32x16, F32x16::div>;
+                ops.relu = [](const float *x, float *y, size_t n)
+                {
+                    simdUnaryRow<F32x16>(x, y, n,
+                                         [](__m512 v)
+                                         { return F32x16::relu(v); });
+                };
+                ops.clip = [](const float *x, float *y, size_t n, float lo,
+                              float hi)
+                {
+                    auto l = F32x16::set1(lo), h = F32x16::set1(hi);
+                    simdUnaryRow<F32x16>(x, y, n,
+                                         [=](__m512 v)
+                                         { return F32x16::clip(v, l, h); });
+                };
+                // every AVX-512 CPU has AVX2, whose tile transpose serves
+                if (auto avx2 = getAvx2Tables().f32)
+                    ops.transpose8x8 = avx2->transpose8x8;
+                return ops;
+            }();
+            return &ops;
+        }
+
+        // relu is a copy for unsigned data and division has no instruction,
+        // both stay with the portable loops
+        const SimdOps<uint32_t> *getU32Ops()
+        {
+            static const SimdOps<uint32_t> ops = []
+            {
+                SimdOps<uint32_t> ops;
+                ops.add = simdBinaryRow<U32x16, U32x16::add>;
+                ops.sub = simdBinaryRow<U32x16, U32x16::sub>;
+                ops.mul = simdBinaryRow<U32x16, U32x16::mul>;
+                ops.clip = [](const uint32_t *x, uint32_t *y, size_t n,
+                              uint32_t lo, uint32_t hi)
+                {
+                    auto l = U32x16::set1(lo), h = U32x16::set1(hi);
+                    simdUnaryRow<U32x16>(x, y, n,
+                                         [=](__m512i v)
+                                         { return U32x16::clip(v, l, h); });
+                };
+                // every AVX-512 CPU has AVX2, whose tile transpose serves
+                if (auto avx2 = getAvx2Tables().u32)
+                    ops.transpose8x8 = avx2->transpose8x8;
+                return ops;
+            }();
+            return &ops;
+        }
+    } // namespace
+
+    SimdTables getAvx512Tables() { return {getF32Ops(), getU32Ops()}; }
+    bool hasAvx512Kernels() { return true; }
+#else
+    SimdTables getAvx512Tables() { return {nullptr, nullptr}; }
+    bool hasAvx512Kernels() { return false; }
+#endif
+} // namespace infini
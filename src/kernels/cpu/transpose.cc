@@ -1,53 +1,197 @@
 #include "operators/transpose.h"
 #include "core/kernel.h"
+#include "utils/simd.h"
+#include <cstring>
 
 namespace infini {
 
-inline Shape idx2Pos(const Shape &shape, size_t idx) {
-    Shape pos = Shape(shape.size(), 0);
-    auto rest = idx, curDimId = shape.size() - 1;
-    while (rest > 0) {
-        pos[curDimId] = rest % shape[curDimId];
-        rest /= shape[curDimId];
-        curDimId--;
+/**
+ * Transposes a reduced form of the permutation: dimensions of size 1 are
+ * dropped and runs of input dimensions that stay adjacent in the output are
+ * merged. What remains is a copy, contiguous rows moved as a whole, or 2D
+ * transposes of the innermost input dimension with the one that becomes the
+ * innermost output dimension, done in 8x8 tiles.
+ */
+class NaiveTranspose : public CpuKernelWithoutConfig {
+    // tiles of the in-register transposes, and the blocks of tiles one
+    // task moves, which keep whole cache lines of the output in flight
+    static constexpr size_t tile = 8, block = 32;
+
+    // a dimension iterated outside of the copies or the tiles
+    struct Dim {
+        size_t size, inStride, outStride;
+    };
+
+    // offsets of the idx-th position of the outer dimensions
+    static pair<size_t, size_t> locate(const vector<Dim> &outer, size_t idx) {
+        size_t inOffset = 0, outOffset = 0;
+        for (size_t d = outer.size(); d > 0; --d) {
+            size_t pos = idx % outer[d - 1].size;
+            idx /= outer[d - 1].size;
+            inOffset += pos * outer[d - 1].inStride;
+            outOffset += pos * outer[d - 1].outStride;
+        }
+        return {inOffset, outOffset};
+    }
+
+    // out[a + b * outStride] = in[a * inStride + b] for a in [a0, a1) and
+    // b in [b0, b1), tile by tile
+    template <typename T>
+    static void transposeBlock(const T *in, size_t inStride, T *out,
+                               size_t outStride, size_t a0, size_t a1,
+                               size_t b0, size_t b1,
+                               void (*simdTile)(const T *, size_t, T *,
+                                                size_t)) {
+        for (size_t a = a0; a < a1; a += tile)
+            for (size_t b = b0; b < b1; b += tile) {
+                const T *src = in + a * inStride + b;
+                T *dst = out + a + b * outStride;
+                if (simdTile && a + tile <= a1 && b + tile <= b1) {
+                    simdTile(src, inStride, dst, outStride);
+                    continue;
+                }
+                for (size_t i = 0; i < std::min(tile, a1 - a); ++i)
+                    for (size_t j = 0; j < std::min(tile, b1 - b); ++j)
+                        dst[i + j * outStride] = src[i * inStride + j];
+            }
     }
-    return pos;
-}
 
-class NaiveTranspose : public CpuKernelWithoutConfig {
     template <typename T>
-    void doCompute(const Operator &_op, const RuntimeObj *context) const {
+    std::function<void()> doPrepare(const Operator &_op,
+                                    const RuntimeObj *context) const {
         auto op = as<TransposeObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
-        const auto &inDim = inputs[0]->getDims();
+        const auto &inDim = op->getInputs(0)->getDims();
         const auto &perm = op->getPermute();
+        auto inPtr = op->getInputs(0)->getRawDataPtr<T *>(),
+             outPtr = op->getOutput()->getRawDataPtr<T *>();
+        size_t n = op->getInputs(0)->size();
 
-        size_t inSize = inputs[0]->size();
-        auto inPtr = inputs[0]->getRawDataPtr<T *>(),
-             outPtr = outputs[0]->getRawDataPtr<T *>();
-        // #pragma omp parallel for
-        for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
-            auto posInput = idx2Pos(inDim, inIdx);
-            int outIdx = 0;
-            for (size_t j = 0, jEnd = perm.size(); j < jEnd; ++j) {
-                outIdx = outIdx * inDim[perm[j]] + posInput[perm[j]];
+        if (n == 0)
+            return [] {};
+
+        // indices of the input dimensions kept, which are not of size 1
+        vector<int> kept(inDim.size(), -1);
+        vector<size_t> keptDim;
+        for (size_t d = 0; d < inDim.size(); ++d)
+            if (inDim[d] != 1) {
+                kept[d] = keptDim.size();
+                keptDim.push_back(inDim[d]);
             }
-            outPtr[outIdx] = inPtr[inIdx];
+        // merge runs of consecutive kept dimensions in output order into
+        // groups of (first kept dimension, size)
+        vector<pair<int, size_t>> groups;
+        int previous = -2;
+        for (auto axis : perm) {
+            int d = kept[axis];
+            if (d < 0)
+                continue;
+            if (d == previous + 1)
+                groups.back().second *= keptDim[d];
+            else
+                groups.push_back({d, keptDim[d]});
+            previous = d;
+        }
+        // a single group is the identity
+        if (groups.size() <= 1)
+            return [=] {
+                context->parallelFor(
+                    n,
+                    [&](size_t begin, size_t end) {
+                        std::memcpy(outPtr + begin, inPtr + begin,
+                                    (end - begin) * sizeof(T));
+                    },
+                    elementGrain);
+            };
+
+        // reduced input dimensions in input order, and the output position
+        // of each
+        auto rank = groups.size();
+        vector<size_t> byInput(rank);
+        for (size_t i = 0; i < rank; ++i)
+            byInput[i] = i;
+        std::sort(byInput.begin(), byInput.end(), [&](size_t a, size_t b) {
+            return groups[a].first < groups[b].first;
+        });
+        vector<Dim> dims(rank);
+        for (size_t d = rank, p = 1; d > 0; --d) {
+            dims[d - 1].size = groups[byInput[d - 1]].second;
+            dims[d - 1].inStride = p;
+            p *= dims[d - 1].size;
         }
+        for (size_t i = rank, p = 1; i > 0; --i) {
+            auto d = std::find(byInput.begin(), byInput.end(), i - 1) -
+                     byInput.begin();
+            dims[d].outStride = p;
+            p *= dims[d].size;
+        }
+
+        auto last = dims.back();
+        if (last.outStride == 1) {
+            // the innermost input dimension stays innermost, whole rows move
+            vector<Dim> outer(dims.begin(), dims.end() - 1);
+            size_t rows = n / last.size;
+            return [=] {
+                context->parallelFor(
+                    rows,
+                    [&](size_t begin, size_t end) {
+                        for (size_t r = begin; r < end; ++r) {
+                            auto [in, out] = locate(outer, r);
+                            std::memcpy(outPtr + out, inPtr + in,
+                                        last.size * sizeof(T));
+                        }
+                    },
+                    std::max<size_t>(1, elementGrain / last.size));
+            };
+        }
+
+        // transpose the innermost input dimension (cols) with the one that
+        // becomes the innermost output dimension (rows), the rest iterate
+        auto rowsAt = std::find_if(dims.begin(), dims.end(),
+                                   [](const Dim &d) { return d.outStride == 1; });
+        auto rows = *rowsAt;
+        vector<Dim> outer;
+        for (auto it = dims.begin(); it != dims.end() - 1; ++it)
+            if (it != rowsAt)
+                outer.push_back(*it);
+        size_t rowBlocks = (rows.size + block - 1) / block;
+        auto simdTile = getSimdOps<T>().transpose8x8;
+        return [=] {
+            // element (a, b) of a matrix: in[a * rows.inStride + b] goes to
+            // out[a + b * last.outStride]
+            context->parallelFor(
+                n / (rows.size * last.size) * rowBlocks,
+                [&](size_t begin, size_t end) {
+                    for (size_t t = begin; t < end; ++t) {
+                        auto [in, out] = locate(outer, t / rowBlocks);
+                        size_t a0 = t % rowBlocks * block;
+                        size_t a1 = std::min(a0 + block, rows.size);
+                        for (size_t b0 = 0; b0 < last.size; b0 += block) {
+                            size_t b1 = std::min(b0 + block, last.size);
+                            transposeBlock(inPtr + in, rows.inStride,
+                                           outPtr + out, last.outStride, a0,
+                                           a1, b0, b1, simdTile);
+                        }
+                    }
+                },
+                std::max<size_t>(1, elementGrain / (block * last.size)));
+        };
     }
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
+        prepare(_op, context)();
+    }
+
+    std::function<void()> prepare(const Operator &_op,
+                                  const RuntimeObj *context) const override {
 #define CASE(N)                                                                \
     case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
         int dataTypeIdx = _op->getDType().getIndex();
         switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
+            CASE(1);  // DataType::Float32
             CASE(12); // DataType::UInt32
-            break;
         default:
             IT_TODO_HALT();
         }
@@ -1,5 +1,7 @@
 #include "operators/unary.h"
 #include "core/kernel.h"
+#include "utils/simd.h"
+#include <cmath>
 
 namespace infini
 {
@@ -11,47 +13,65 @@ namespace infini
             return std::max(T(0), val);
         }
 
-        template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        // simdRow replaces the portable loop on the CPUs that have it
+        template <typename T, T (*op)(T)>
+        std::function<void()>
+        doPrepare(const Operator &_op, const RuntimeObj *context,
+                  void (*simdRow)(const T *, T *, size_t)) const
         {
-            auto op = as<UnaryObj>(_op);
-            T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            T *inptr = _op->getInputs(0)->getRawDataPtr<T *>();
+            T *outptr = _op->getOutput()->getRawDataPtr<T *>();
 
-            auto outDim = op->getOutput()->getDims();
-            auto n = op->getOutput()->size();
+            auto n = _op->getOutput()->size();
+            return [=]
+            {
+                context->parallelFor(
+                    n,
+                    [&](size_t begin, size_t end)
+                    {
+                        if (simdRow)
+                            simdRow(inptr + begin, outptr + begin,
+                                    end - begin);
+                        else
+                            for (size_t offset = begin; offset < end; offset++)
+                                outptr[offset] = op(inptr[offset]);
+                    },
+                    elementGrain);
+            };
+        }
 
-            T (*_doCompute)
-            (T val);
-            switch (op->getOpType().underlying())
+        template <typename T>
+        std::function<void()> doPrepare(const Operator &_op,
+                                        const RuntimeObj *context) const
+        {
+            switch (_op->getOpType().underlying())
             {
             case OpType::Relu:
-                _doCompute = reluCompute<T>;
-                break;
+                return doPrepare<T, reluCompute<T>>(_op, context,
+                                                    getSimdOps<T>().relu);
             default:
                 IT_TODO_HALT();
             }
-
-            for (size_t offset = 0; offset < n; offset++)
-            {
-                outptr[offset] = _doCompute(inptr[offset]);
-            }
         }
 
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
+            prepare(_op, context)();
+        }
+
+        std::function<void()> prepare(const Operator &_op,
+                                      const RuntimeObj *context) const override
+        {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
             default:
                 IT_TODO_HALT();
             }
@@ -60,8 +80,34 @@ namespace infini
 
     class Clip : public CpuKernelWithoutConfig
     {
+        // Bounds of the vectorized clip, which compares in T, equivalent to
+        // the float comparisons of the portable loop. An absent bound becomes
+        // the extreme of T. Integer data needs integral bounds below 2^24,
+        // which float represents exactly; otherwise there are none.
+        template <typename T>
+        static optional<pair<T, T>> simdBounds(optional<float> minValue,
+                                               optional<float> maxValue)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                return pair<T, T>{
+                    minValue ? *minValue : -std::numeric_limits<T>::infinity(),
+                    maxValue ? *maxValue : std::numeric_limits<T>::infinity()};
+            else
+            {
+                auto exact = [](float v)
+                { return v >= 0 && v <= float(1 << 24) && std::floor(v) == v; };
+                if ((minValue && !exact(*minValue)) ||
+                    (maxValue && !exact(*maxValue)))
+                    return std::nullopt;
+                return pair<T, T>{
+                    minValue ? T(*minValue) : std::numeric_limits<T>::min(),
+                    maxValue ? T(*maxValue) : std::numeric_limits<T>::max()};
+            }
+        }
+
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        std::function<void()> doPrepare(const Operator &_op,
+                                        const RuntimeObj *context) const
         {
             auto op = as<ClipObj>(_op);
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
@@ -70,36 +116,64 @@ namespace infini
             auto maxValue = op->getMax();
 
             auto n = op->getOutput()->size();
-            for (size_t offset = 0; offset < n; offset++)
+            if (auto simdRow = getSimdOps<T>().clip)
+                if (auto bounds = simdBounds<T>(minValue, maxValue))
+                    return [=, lo = bounds->first, hi = bounds->second]
+                    {
+                        context->parallelFor(
+                            n,
+                            [&](size_t begin, size_t end)
+                            {
+                                simdRow(inptr + begin, outptr + begin,
+                                        end - begin, lo, hi);
+                            },
+                            elementGrain);
+                    };
+            return [=]
             {
-                auto val = *inptr++;
-                *outptr++ = (minValue && val < *minValue)   ? *minValue
-                            : (maxValue && val > *maxValue) ? *maxValue
-                                                            : val;
-            }
+                context->parallelFor(
+                    n,
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t offset = begin; offset < end; offset++)
+                        {
+                            auto val = inptr[offset];
+                            outptr[offset] =
+                                (minValue && val < *minValue)   ? *minValue
+                                : (maxValue && val > *maxValue) ? *maxValue
+                                                                : val;
+                        }
+                    },
+                    elementGrain);
+            };
         }
 
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
+            prepare(_op, context)();
+        }
+
+        std::function<void()> prepare(const Operator &_op,
+                                      const RuntimeObj *context) const override
+        {
 #define CASE(N) \
     case N:     \
-        doCompute<DT<N>::t>(_op, context)
+        return doPrepare<DT<N>::t>(_op, context)
 
             int dataTypeIdx = _op->getDType().getIndex();
             switch (dataTypeIdx)
             {
                 CASE(1); // DataType::Float32
-                break;
                 CASE(12); // DataType::UInt32
-                break;
             default:
                 IT_TODO_HALT();
             }
         }
     };
 
-    REGISTER_KERNEL(Device::CPU, OpType::Relu, NativeUnary, "reluNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Clip, Clip, "Clip_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Relu, NativeUnary,
+                            "reluNaive_CPU");
+    REGISTER_INPLACE_KERNEL(Device::CPU, OpType::Clip, Clip, "Clip_CPU");
 
 }; // namespace infini
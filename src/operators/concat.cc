@@ -13,10 +13,16 @@ optional<vector<Shape>> ConcatObj::inferShape(const TensorVec &inputs) {
     Shape dims = inputs[0]->getDims();
     auto rank = inputs[0]->getRank();
 
-    // =================================== 作业 ===================================
-    // TODO：修改 dims，返回正确的 concat 后的 shape
-    // REF: https://onnx.ai/onnx/operators/onnx__Concat.html#concat-13
-    // =================================== 作业 ===================================
+    for (size_t i = 1; i < inputs.size(); ++i) {
+        auto iDims = inputs[i]->getDims();
+        if (inputs[i]->getRank() != rank)
+            return std::nullopt;
+        for (size_t j = 0; j < rank; ++j) {
+            if ((int)j != dim && iDims[j] != dims[j])
+                return std::nullopt;
+        }
+        dims[dim] += iDims[dim];
+    }
 
     return {{dims}};
 }
@@ -35,4 +41,6 @@ std::string ConcatObj::toString() const {
     return os.str();
 }
 
+vector<int64_t> ConcatObj::getOpAttrVector() const { return {dim}; }
+
 } // namespace infini
@@ -1,4 +1,5 @@
 #include "operators/matmul.h"
+#include "utils/operator_utils.h"
 
 namespace infini
 {
@@ -21,13 +22,28 @@ namespace infini
         return os.str();
     }
 
+    vector<int64_t> MatmulObj::getOpAttrVector() const
+    {
+        return {transA, transB};
+    }
+
     optional<vector<Shape>> MatmulObj::inferShape(const TensorVec &inputs)
     {
-        // =================================== 作业 ===================================
-        // TODO：返回经过 matmul 操作后的 shape
-        // REF: https://github.com/onnx/onnx/blob/main/docs/Operators.md#gemm
-        // =================================== 作业 ===================================
-        return std::nullopt;
+        const auto &A = inputs[0]->getDims(), &B = inputs[1]->getDims();
+        if (A.size() < 2 || B.size() < 2)
+            return std::nullopt;
+        auto rankA = A.size(), rankB = B.size();
+        m = transA ? A[rankA - 1] : A[rankA - 2];
+        k = transA ? A[rankA - 2] : A[rankA - 1];
+        n = transB ? B[rankB - 2] : B[rankB - 1];
+        if ((transB ? B[rankB - 1] : B[rankB - 2]) != k)
+            return std::nullopt;
+        // the leading dimensions broadcast
+        auto ret = infer_broadcast(Shape(A.begin(), A.end() - 2),
+                                   Shape(B.begin(), B.end() - 2));
+        ret.push_back(m);
+        ret.push_back(n);
+        return {{ret}};
     }
 
 } // namespace infini
\ No newline at end of file
@@ -9,6 +9,7 @@ namespace infini
         auto rank = input->getRank();
         if (permute.empty())
         {
+            transposePermute.resize(rank);
             for (size_t i = 0; i < rank; ++i)
             {
                 transposePermute[i] = i;
@@ -29,12 +30,17 @@ namespace infini
         auto output_dim = input_dim;
         int rank = A->getRank();
 
-        // =================================== 作业 ===================================
-        // TODO：修改 output_dim，返回正确的 transpose 后的 shape
-        // REF: https://onnx.ai/onnx/operators/onnx__Transpose.html#transpose-21
-        // =================================== 作业 ===================================
-
-        return std::nullopt;
+        // every input dimension appears once in the output
+        vector<bool> used(rank);
+        for (int i = 0; i < rank; ++i)
+        {
+            int axis = transposePermute[i];
+            if (axis < 0 || axis >= rank || used[axis])
+                return std::nullopt;
+            used[axis] = true;
+            output_dim[i] = input_dim[axis];
+        }
+        return {{output_dim}};
     }
 
     std::string TransposeObj::toString() const
@@ -47,4 +53,9 @@ namespace infini
         os << "output=" << outputs[0]->getGuid() << ")";
         return os.str();
     }
+
+    vector<int64_t> TransposeObj::getOpAttrVector() const
+    {
+        return vector<int64_t>(transposePermute.begin(), transposePermute.end());
+    }
 }; // namespace infini
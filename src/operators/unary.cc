@@ -1,4 +1,5 @@
 #include "operators/unary.h"
+#include <cstring>
 
 namespace infini
 {
@@ -35,11 +36,23 @@ namespace infini
 
     optional<vector<Shape>> ClipObj::inferShape(const TensorVec &inputs)
     {
-        // =================================== 作业 ===================================
-        // TODO：返回经过 clip 操作后的 shape
-        // REF: https://onnx.ai/onnx/operators/onnx__Clip.html#clip-13
-        // =================================== 作业 ===================================
-        return std::nullopt;
+        const auto A = inputs[0];
+        return {{A->getDims()}};
+    }
+
+    vector<int64_t> ClipObj::getOpAttrVector() const
+    {
+        // presence and bit pattern of each bound
+        vector<int64_t> ret;
+        for (auto bound : {minValue, maxValue})
+        {
+            uint32_t bits = 0;
+            if (bound)
+                std::memcpy(&bits, &*bound, sizeof(bits));
+            ret.push_back(bound.has_value());
+            ret.push_back(bits);
+        }
+        return ret;
     }
 
     std::string ClipObj::toString() const
@@ -78,6 +91,11 @@ namespace infini
         return std::nullopt;
     }
 
+    vector<int64_t> CastObj::getOpAttrVector() const
+    {
+        return {int64_t(castType)};
+    }
+
     std::string CastObj::toString() const
     {
         std::ostringstream os;
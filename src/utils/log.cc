@@ -0,0 +1,12 @@
+#include "utils/log.h"
+#include <atomic>
+
+namespace infini
+{
+    static std::atomic<LogLevel> logLevel{LogLevel::Info};
+
+    LogLevel getLogLevel() { return logLevel; }
+
+    void setLogLevel(LogLevel level) { logLevel = level; }
+
+} // namespace infini
@@ -4,13 +4,18 @@
 namespace infini {
 
 Shape infer_broadcast(const Shape &A, const Shape &B) {
-
-    // =================================== 作业 ===================================
-    // TODO：对 A 和 B 进行双向广播，返回广播后的形状。
-    // REF: https://github.com/onnx/onnx/blob/main/docs/Broadcasting.md
-    // =================================== 作业 ===================================
-    
-    return {};
+    // align the trailing dimensions, a dimension of 1 stretches to the other
+    auto rank = std::max(A.size(), B.size());
+    Shape ret(rank);
+    for (size_t i = 0; i < rank; ++i) {
+        int a = i < rank - A.size() ? 1 : A[i - (rank - A.size())];
+        int b = i < rank - B.size() ? 1 : B[i - (rank - B.size())];
+        IT_ASSERT(a == b || a == 1 || b == 1, "Shapes " + vecToString(A) +
+                                                  " and " + vecToString(B) +
+                                                  " cannot be broadcast");
+        ret[i] = a == 1 ? b : a;
+    }
+    return ret;
 }
 
 int get_real_axis(const int &axis, const int &rank) {
@@ -0,0 +1,120 @@
+#include "utils/simd.h"
+#include <atomic>
+#include <mutex>
+
+namespace infini
+{
+    string toString(CpuIsa isa)
+    {
+        switch (isa)
+        {
+        case CpuIsa::Generic:
+            return "Generic";
+        case CpuIsa::AVX2:
+            return "AVX2";
+        case CpuIsa::AVX512:
+            return "AVX512";
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    // tables of each level built so far, indexed by CpuIsa
+    static std::atomic<bool> built[3];
+
+    // Builds the tables of `isa`, which must not be wider than the CPU
+    static SimdTables getTables(CpuIsa isa)
+    {
+        switch (isa)
+        {
+        case CpuIsa::AVX2:
+            built[int(CpuIsa::AVX2)] = true;
+            return getAvx2Tables();
+        case CpuIsa::AVX512:
+            // the AVX-512 tables take the AVX2 loops they have no match for
+            built[int(CpuIsa::AVX2)] = built[int(CpuIsa::AVX512)] = true;
+            return getAvx512Tables();
+        default:
+            return {nullptr, nullptr};
+        }
+    }
+
+    static bool hasKernels(CpuIsa isa)
+    {
+        switch (isa)
+        {
+        case CpuIsa::AVX2:
+            return hasAvx2Kernels();
+        case CpuIsa::AVX512:
+            return hasAvx512Kernels();
+        default:
+            return true;
+        }
+    }
+
+    bool isSimdTableBuilt(CpuIsa isa) { return built[int(isa)]; }
+
+    CpuIsa detectCpuIsa()
+    {
+        static const CpuIsa detected = []
+        {
+            auto isa = CpuIsa::Generic;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                isa = CpuIsa::AVX512;
+            else if (__builtin_cpu_supports("avx2") &&
+                     __builtin_cpu_supports("fma"))
+                isa = CpuIsa::AVX2;
+#endif
+            // skip the levels the build has no kernels for
+            while (!hasKernels(isa))
+                isa = CpuIsa(int(isa) - 1);
+            return isa;
+        }();
+        return detected;
+    }
+
+    static std::atomic<CpuIsa> &currentIsa()
+    {
+        static std::atomic<CpuIsa> isa{detectCpuIsa()};
+        return isa;
+    }
+
+    CpuIsa getCpuIsa() { return currentIsa(); }
+
+    void setCpuIsa(CpuIsa isa)
+    {
+        IT_ASSERT(isa <= detectCpuIsa(),
+                  toString(isa) + " is not supported on this machine");
+        currentIsa() = isa;
+    }
+
+    template <typename T>
+    const SimdOps<T> &getSimdOps()
+    {
+        static const SimdOps<T> generic;
+        // one table per level, indexed by CpuIsa and built on first use
+        static std::once_flag once[3];
+        static const SimdOps<T> *tables[3];
+        auto isa = getCpuIsa();
+        std::call_once(once[int(isa)], [isa]
+                       {
+                           const SimdOps<T> *ops = nullptr;
+                           // levels above the CPU are never built
+                           if (isa <= detectCpuIsa())
+                           {
+                               auto all = getTables(isa);
+                               if constexpr (std::is_same_v<T, float>)
+                                   ops = all.f32;
+                               else
+                                   ops = all.u32;
+                           }
+                           tables[int(isa)] = ops ? ops : &generic; });
+        return *tables[int(isa)];
+    }
+
+    template const SimdOps<float> &getSimdOps<float>();
+    template const SimdOps<uint32_t> &getSimdOps<uint32_t>();
+
+} // namespace infini
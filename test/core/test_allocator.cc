@@ -71,4 +71,48 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testFreeMerge)
+    {
+        Shape shape = Shape{1, 2, 2, 3};
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Tensor a = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor b = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor c = make_ref<TensorObj>(shape, DataType::Float32, runtime);
+        Tensor d =
+            make_ref<TensorObj>(Shape{2, 2, 2, 3}, DataType::Float32, runtime);
+        Allocator allocator = Allocator(runtime);
+        // allocate a->b->c
+        size_t offsetA = allocator.alloc(a->getBytes());
+        size_t offsetB = allocator.alloc(b->getBytes());
+        allocator.alloc(c->getBytes());
+        size_t peak = allocator.getPeak();
+        // free a and b, the two free blocks should be merged to hold d
+        allocator.free(offsetA, a->getBytes());
+        allocator.free(offsetB, b->getBytes());
+        EXPECT_EQ(allocator.getFragmentation(), 0.);
+        size_t offsetD = allocator.alloc(d->getBytes());
+        EXPECT_EQ(offsetA, offsetD);
+        EXPECT_EQ(allocator.getPeak(), peak);
+        EXPECT_EQ(allocator.getUsed(), peak);
+    }
+
+    TEST(Allocator, testAlignment)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Tensor a = make_ref<TensorObj>(Shape{1, 2, 2, 3}, DataType::Float32,
+                                       runtime);
+        Tensor b = make_ref<TensorObj>(Shape{5}, DataType::Float32, runtime);
+        Allocator allocator = Allocator(runtime);
+        allocator.setAlignment(64);
+        size_t offsetA = allocator.alloc(a->getBytes());
+        size_t offsetB = allocator.alloc(b->getBytes());
+        EXPECT_EQ(offsetA, 0);
+        EXPECT_EQ(offsetB, 64);
+        EXPECT_EQ(allocator.getPadding(), (64 - 48) + (64 - 20));
+        allocator.free(offsetA, a->getBytes());
+        EXPECT_EQ(allocator.getPadding(), 64 - 20);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(allocator.getPtr()) % 64, 0);
+        EXPECT_THROW(allocator.setAlignment(128), Exception);
+    }
+
 } // namespace infini
@@ -0,0 +1,84 @@
+#include "core/frozen_graph.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// counts the heap allocations of the whole test program, GCC does not see
+// that the replaced operator new uses malloc
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace infini
+{
+    TEST(FrozenGraph, Run)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, 1.0f, 4.0f)->getOutput();
+        auto y = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{x, y}, nullptr, 1);
+        g->dataMalloc();
+
+        FrozenGraph frozen(g);
+        auto &tensors = frozen.getTensors();
+        ASSERT_EQ(frozen.getInputs().size(), 1u);
+        ASSERT_EQ(frozen.getOutputs().size(), 1u);
+        auto &input = tensors[frozen.getInputs()[0]];
+        auto &output = tensors[frozen.getOutputs()[0]];
+        EXPECT_EQ(input.fuid, i->getFuid());
+        EXPECT_EQ(output.dims, (Shape{2, 6}));
+        ASSERT_EQ(frozen.getOperators().size(), 3u);
+        EXPECT_EQ(frozen.getOperators()[2].guid, op->getGuid());
+        EXPECT_EQ(frozen.getOperators()[2].kernel, "ConcatNaive_CPU");
+
+        auto in = static_cast<float *>(input.data);
+        for (int k = 0; k < 6; ++k)
+            in[k] = float(k);
+        auto before = allocations.load();
+        frozen.run();
+        EXPECT_EQ(allocations.load(), before);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{1, 1, 2, 0, 1, 2, 3, 4, 4, 3, 4, 5}));
+    }
+
+    TEST(FrozenGraph, Broadcast)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({4, 8}, DataType::Float32);
+        Tensor b = g->addTensor({1, 8}, DataType::Float32);
+        auto op = g->addOp<AddObj>(a, b, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+
+        FrozenGraph frozen(g);
+        auto before = allocations.load();
+        frozen.run();
+        EXPECT_EQ(allocations.load(), before);
+        vector<float> expected(32);
+        for (size_t k = 0; k < expected.size(); ++k)
+            expected[k] = float(k + 1);
+        EXPECT_TRUE(op->getOutput()->equalData(expected));
+    }
+
+} // namespace infini
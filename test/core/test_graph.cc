@@ -1,8 +1,11 @@
 #include "core/graph.h"
 #include "core/kernel.h"
 #include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
 #include "operators/matmul.h"
 #include "operators/transpose.h"
+#include "operators/unary.h"
 
 #include "test.h"
 
@@ -37,4 +40,307 @@ namespace infini
         EXPECT_EQ(op->getTransA(), false);
         EXPECT_EQ(op->getTransB(), true);
     }
-}
\ No newline at end of file
+
+    TEST(Graph, DataMalloc)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        auto r3 = g->addOp<ReluObj>(r2->getOutput(), nullptr);
+        g->dataMalloc();
+        // the graph input is kept, the rest of the chain runs in place
+        EXPECT_NE(r1->getOutput()->getRawDataPtr<void *>(),
+                  i->getRawDataPtr<void *>());
+        EXPECT_EQ(r2->getOutput()->getRawDataPtr<void *>(),
+                  r1->getOutput()->getRawDataPtr<void *>());
+        EXPECT_EQ(r3->getOutput()->getRawDataPtr<void *>(),
+                  r1->getOutput()->getRawDataPtr<void *>());
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(r3->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+    }
+
+    TEST(Graph, MemoryPlanStrategies)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        for (auto strategy :
+             {MemoryPlanStrategy::Sequential, MemoryPlanStrategy::GreedyBySize,
+              MemoryPlanStrategy::GreedyByBreadth,
+              MemoryPlanStrategy::IntervalColoring})
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            g->setAlignment(64);
+            Tensor i0 = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+            Tensor i1 = g->addTensor({4, 2, 2, 3}, DataType::Float32);
+            auto r0 = g->addOp<ReluObj>(i0, nullptr);
+            auto r1 = g->addOp<ReluObj>(i1, nullptr);
+            auto r2 = g->addOp<ReluObj>(r0->getOutput(), nullptr);
+            auto r3 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+            auto r4 = g->addOp<ReluObj>(r2->getOutput(), nullptr);
+            auto peaks = g->compareMemoryPlans();
+            EXPECT_EQ(peaks.size(), 4);
+            // i1 and the outputs of r0 and r1 are alive at r1
+            for (auto &[s, peak] : peaks)
+                EXPECT_GE(peak, 48 + 192 * 2);
+            g->dataMalloc(strategy);
+            i0->setData(IncrementalGenerator());
+            i1->setData(IncrementalGenerator());
+            runtime->run(g);
+            vector<float> ans(48);
+            for (size_t i = 0; i < ans.size(); ++i)
+                ans[i] = i;
+            EXPECT_TRUE(r3->getOutput()->equalData(ans));
+            ans.resize(12);
+            EXPECT_TRUE(r4->getOutput()->equalData(ans));
+            // i0 and the output of r0, shared by r2 and r4, are padded from
+            // 48 to 64 bytes
+            EXPECT_EQ(g->getMemoryPlan().padding, 2 * (64 - 48));
+        }
+    }
+
+    TEST(Graph, InPlace)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        auto r = g->addOp<ReluObj>(i, nullptr);
+        auto c0 = g->addOp<ClipObj>(r->getOutput(), nullptr, 2.0f, 9.0f);
+        // the output of r is still read by c1, so c0 can not run in place
+        auto c1 = g->addOp<ClipObj>(r->getOutput(), nullptr, std::nullopt,
+                                    5.0f);
+        g->dataMalloc();
+        EXPECT_NE(c0->getOutput()->getRawDataPtr<void *>(),
+                  r->getOutput()->getRawDataPtr<void *>());
+        EXPECT_EQ(c1->getOutput()->getRawDataPtr<void *>(),
+                  r->getOutput()->getRawDataPtr<void *>());
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(c0->getOutput()->equalData(
+            vector<float>{2, 2, 2, 3, 4, 5, 6, 7, 8, 9, 9, 9}));
+        EXPECT_TRUE(c1->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 5, 5, 5, 5, 5, 5}));
+    }
+
+    TEST(Graph, ZeroCopyConcat)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i0 = g->addTensor({1, 2, 3}, DataType::Float32);
+        Tensor i1 = g->addTensor({1, 1, 3}, DataType::Float32);
+        auto r0 = g->addOp<ReluObj>(i0, nullptr);
+        auto r1 = g->addOp<ReluObj>(i1, nullptr);
+        // i1 is a graph input, it is copied by the kernel
+        auto op = g->addOp<ConcatObj>(
+            TensorVec{r0->getOutput(), r1->getOutput(), i1}, nullptr, 1);
+        g->dataMalloc();
+        auto outPtr = op->getOutput()->getRawDataPtr<float *>();
+        EXPECT_EQ(r0->getOutput()->getRawDataPtr<float *>(), outPtr);
+        EXPECT_EQ(r1->getOutput()->getRawDataPtr<float *>(), outPtr + 6);
+        EXPECT_NE(i1->getRawDataPtr<float *>(), outPtr + 9);
+        i0->setData(IncrementalGenerator());
+        i1->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 1, 1, 1, 1, 1, 1}));
+
+        // slices starting off the alignment keep their own memory
+        Graph h = make_ref<GraphObj>(runtime);
+        h->setAlignment(64);
+        Tensor j0 = h->addTensor({1, 3, 5}, DataType::Float32);
+        Tensor j1 = h->addTensor({1, 3, 5}, DataType::Float32);
+        auto s0 = h->addOp<ReluObj>(j0, nullptr);
+        auto s1 = h->addOp<ReluObj>(j1, nullptr);
+        auto cat = h->addOp<ConcatObj>(
+            TensorVec{s0->getOutput(), s1->getOutput()}, nullptr, 1);
+        h->dataMalloc();
+        auto catPtr = cat->getOutput()->getRawDataPtr<float *>();
+        EXPECT_EQ(s0->getOutput()->getRawDataPtr<float *>(), catPtr);
+        EXPECT_NE(s1->getOutput()->getRawDataPtr<float *>(), catPtr + 15);
+        for (auto &tensor : h->getTensors())
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(
+                          tensor->getRawDataPtr<void *>()) %
+                          64,
+                      0u);
+        j0->setData(IncrementalGenerator());
+        j1->setData(OneGenerator());
+        runtime->run(h);
+        vector<float> expected(30, 1);
+        for (size_t k = 0; k < 15; ++k)
+            expected[k] = float(k);
+        EXPECT_TRUE(cat->getOutput()->equalData(expected));
+    }
+
+    TEST(Graph, ConstantWeights)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        w->setConstant();
+        auto r0 = g->addOp<ReluObj>(w, nullptr);
+        auto r1 = g->addOp<ReluObj>(r0->getOutput(), nullptr);
+        g->dataMalloc();
+        auto wPtr = w->getRawDataPtr<void *>();
+        auto activationPtr = r0->getOutput()->getRawDataPtr<void *>();
+        w->setData(IncrementalGenerator());
+        // planning again keeps the weights and reuses the activation memory
+        g->dataMalloc(MemoryPlanStrategy::GreedyBySize);
+        EXPECT_EQ(w->getRawDataPtr<void *>(), wPtr);
+        EXPECT_EQ(r0->getOutput()->getRawDataPtr<void *>(), activationPtr);
+        runtime->run(g);
+        EXPECT_TRUE(r1->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+    }
+
+    TEST(Graph, SharedActivations)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        vector<Graph> graphs;
+        vector<Tensor> inputs, outputs;
+        for (auto shape : {Shape{1, 2, 2, 3}, Shape{4, 2, 2, 3}})
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor i = g->addTensor(shape, DataType::Float32);
+            auto r0 = g->addOp<ReluObj>(i, nullptr);
+            auto r1 = g->addOp<ReluObj>(r0->getOutput(), nullptr);
+            graphs.emplace_back(g);
+            inputs.emplace_back(i);
+            outputs.emplace_back(r1->getOutput());
+        }
+        GraphObj::dataMalloc(graphs);
+        EXPECT_EQ(inputs[0]->getRawDataPtr<void *>(),
+                  inputs[1]->getRawDataPtr<void *>());
+        for (size_t i = 0; i < graphs.size(); ++i)
+        {
+            inputs[i]->setData(IncrementalGenerator());
+            runtime->run(graphs[i]);
+            vector<float> ans(outputs[i]->size());
+            for (size_t j = 0; j < ans.size(); ++j)
+                ans[j] = j;
+            EXPECT_TRUE(outputs[i]->equalData(ans));
+        }
+
+        Graph other = make_ref<GraphObj>(runtime);
+        other->setAlignment(128);
+        other->addOp<ReluObj>(other->addTensor({1, 3}, DataType::Float32),
+                              nullptr);
+        EXPECT_THROW(GraphObj::dataMalloc({graphs[0], other}), Exception);
+    }
+
+    TEST(Graph, PlanCache)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        auto r0 = g->addOp<ReluObj>(i, nullptr);
+        auto r1 = g->addOp<ReluObj>(r0->getOutput(), nullptr);
+        for (auto batch : {1, 4, 1, 4})
+        {
+            i->setShape({batch, 2, 2, 3});
+            g->shape_infer();
+            g->dataMalloc();
+            i->setData(IncrementalGenerator());
+            runtime->run(g);
+            vector<float> ans(batch * 12);
+            for (size_t j = 0; j < ans.size(); ++j)
+                ans[j] = j;
+            EXPECT_TRUE(r1->getOutput()->equalData(ans));
+        }
+        EXPECT_EQ(g->getPlanCacheSize(), 2);
+    }
+
+    TEST(Graph, MemoryPlanExport)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        auto r0 = g->addOp<ReluObj>(i, nullptr);
+        auto r1 = g->addOp<ReluObj>(r0->getOutput(), nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        g->dataMalloc();
+        const auto &plan = g->getMemoryPlan();
+        ASSERT_EQ(plan.tensors.size(), 4);
+        // i is read by r0, r1 runs in place on the output of r0
+        EXPECT_EQ(plan.tensors[0].fuid, i->getFuid());
+        EXPECT_EQ(plan.tensors[0].first, 0);
+        EXPECT_EQ(plan.tensors[0].last, 0);
+        EXPECT_EQ(plan.tensors[2].first, 1);
+        EXPECT_EQ(plan.tensors[2].last, 2);
+        EXPECT_EQ(plan.tensors[2].offset, plan.tensors[1].offset);
+        ASSERT_EQ(plan.timeline.size(), 3);
+        EXPECT_EQ(plan.timeline[0].live, 96);
+        EXPECT_EQ(plan.timeline[2].live, 48);
+        EXPECT_EQ(plan.timeline[2].footprint, 96);
+        EXPECT_DOUBLE_EQ(plan.timeline[2].fragmentation, 0.5);
+        EXPECT_EQ(plan.tensorsToCsv().find("fuid,offset,bytes,first,last\n"),
+                  0);
+        EXPECT_EQ(plan.timelineToCsv().find("op,live,footprint,fragmentation\n"),
+                  0);
+        EXPECT_EQ(plan.toJson().find("{\"peak\": 96, \"tensors\": [{"), 0);
+    }
+
+    TEST(Graph, SetInputShapes)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({4, 3}, DataType::Float32);
+        Tensor j = g->addTensor({2, 3}, DataType::Float32);
+        auto r = g->addOp<ReluObj>(i, nullptr);
+        auto c = g->addOp<ClipObj>(r->getOutput(), nullptr, 0.0f, 5.0f);
+        auto other = g->addOp<ReluObj>(j, nullptr);
+        g->dataMalloc();
+        auto otherDims = other->getOutput()->getDims();
+
+        auto check = [&](size_t n)
+        {
+            i->setData(IncrementalGenerator());
+            j->setData(IncrementalGenerator());
+            runtime->run(g);
+            vector<float> expected(n);
+            for (size_t k = 0; k < n; ++k)
+                expected[k] = std::min(float(k), 5.0f);
+            EXPECT_TRUE(c->getOutput()->equalData(expected));
+            EXPECT_TRUE(other->getOutput()->equalData(
+                vector<float>{0, 1, 2, 3, 4, 5}));
+        };
+        check(12);
+
+        // smaller tensors keep the plan
+        auto ptr = c->getOutput()->getRawDataPtr<void *>();
+        EXPECT_FALSE(g->setInputShapes({{i, {2, 3}}}));
+        EXPECT_EQ(c->getOutput()->getDims(), (Shape{2, 3}));
+        EXPECT_EQ(c->getOutput()->getRawDataPtr<void *>(), ptr);
+        EXPECT_EQ(other->getOutput()->getDims(), otherDims);
+        check(6);
+
+        // larger ones are planned again
+        EXPECT_TRUE(g->setInputShapes({{i, {8, 3}}}));
+        EXPECT_EQ(c->getOutput()->getDims(), (Shape{8, 3}));
+        check(24);
+
+        EXPECT_FALSE(g->setInputShapes({{i, {8, 3}}}));
+        EXPECT_THROW(g->setInputShapes({{r->getOutput(), {1, 3}}}), Exception);
+
+        // an output planned in place over an input that is broadcast now
+        Graph h = make_ref<GraphObj>(runtime);
+        Tensor x = h->addTensor({4, 4}, DataType::Float32);
+        Tensor y = h->addTensor({4, 4}, DataType::Float32);
+        auto a = h->addOp<ReluObj>(x, nullptr);
+        auto add = h->addOp<AddObj>(a->getOutput(), y, nullptr);
+        h->dataMalloc();
+        EXPECT_EQ(add->getOutput()->getRawDataPtr<void *>(),
+                  a->getOutput()->getRawDataPtr<void *>());
+        EXPECT_TRUE(h->setInputShapes({{x, {1, 4}}}));
+        EXPECT_NE(add->getOutput()->getRawDataPtr<void *>(),
+                  a->getOutput()->getRawDataPtr<void *>());
+        x->setData(IncrementalGenerator());
+        y->setData(OneGenerator());
+        runtime->run(h);
+        vector<float> expected(16);
+        for (size_t k = 0; k < 16; ++k)
+            expected[k] = float(k % 4 + 1);
+        EXPECT_TRUE(add->getOutput()->equalData(expected));
+    }
+}
@@ -0,0 +1,53 @@
+#include "core/graph.h"
+#include "core/graph_instance.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(GraphInstance, RunAsync)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setRequestThreads(3);
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w = g->addTensor({1, 3}, DataType::Float32);
+        w->setConstant();
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, 0.0f, 4.0f)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{x, w}, nullptr, 0);
+        g->dataMalloc();
+        w->setData(IncrementalGenerator());
+
+        vector<Ref<GraphInstance>> instances;
+        vector<std::future<void>> futures;
+        for (int k = 0; k < 8; ++k)
+        {
+            auto instance = make_ref<GraphInstance>(g);
+            // the weights are shared, the activations are not
+            EXPECT_EQ(instance->getRawDataPtr<void *>(w),
+                      w->getRawDataPtr<void *>());
+            EXPECT_NE(instance->getRawDataPtr<void *>(i),
+                      i->getRawDataPtr<void *>());
+            auto input = instance->getRawDataPtr<float *>(i);
+            for (int j = 0; j < 6; ++j)
+                input[j] = float(j + k - 3);
+            futures.emplace_back(runtime->runAsync(instance));
+            instances.emplace_back(instance);
+        }
+        for (int k = 0; k < 8; ++k)
+        {
+            futures[k].get();
+            auto output = instances[k]->getRawDataPtr<float *>(op->getOutput());
+            for (int j = 0; j < 6; ++j)
+                EXPECT_EQ(output[j], std::min(std::max(float(j + k - 3), 0.0f),
+                                              4.0f));
+            for (int j = 0; j < 3; ++j)
+                EXPECT_EQ(output[6 + j], float(j));
+        }
+        EXPECT_THROW(runtime->setRequestThreads(2), Exception);
+    }
+
+} // namespace infini
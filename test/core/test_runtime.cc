@@ -0,0 +1,268 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/profiler.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    // a correct but slow relu, which kernel tuning must not choose
+    class SlowRelu : public CpuKernelWithoutConfig
+    {
+        void compute(const Operator &op,
+                     const RuntimeObj *context) const override
+        {
+            auto input = op->getInputs(0)->getRawDataPtr<float *>();
+            auto output = op->getOutput()->getRawDataPtr<float *>();
+            for (size_t i = 0; i < op->getOutput()->size(); ++i)
+                output[i] = std::max(input[i], 0.0f);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    };
+
+    REGISTER_INPLACE_KERNEL_VARIANT(Device::CPU, OpType::Relu, SlowRelu,
+                                    "reluSlow_CPU");
+
+    TEST(Runtime, AllocMode)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setAllocMode(CpuAllocMode::Aligned, 128);
+        void *ptr = runtime->alloc(100);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 128, 0);
+        runtime->dealloc(ptr);
+
+        runtime->setAllocMode(CpuAllocMode::HugePage);
+        ptr = runtime->alloc(100);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % (2 << 20), 0);
+        // the mapping is still released after switching back
+        runtime->setAllocMode(CpuAllocMode::Zeroed);
+        runtime->dealloc(ptr);
+
+        EXPECT_THROW(runtime->setAllocMode(CpuAllocMode::Aligned, 48),
+                     Exception);
+    }
+
+    TEST(Runtime, RunOnHugePages)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setAllocMode(CpuAllocMode::HugePage);
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({1, 2, 2, 3}, DataType::Float32);
+        auto op = g->addOp<ReluObj>(i, nullptr);
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+    }
+
+    TEST(Runtime, InterOpParallel)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        // four independent branches joined by a concat
+        auto build = [&]
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+            TensorVec branches;
+            for (int b = 0; b < 4; ++b)
+            {
+                auto x = g->addOp<ClipObj>(i, nullptr, -float(b), 10.0f)
+                             ->getOutput();
+                x = g->addOp<ReluObj>(x, nullptr)->getOutput();
+                x = g->addOp<ClipObj>(x, nullptr, 1.0f, 20.0f - b)
+                        ->getOutput();
+                branches.push_back(x);
+            }
+            auto op = g->addOp<ConcatObj>(branches, nullptr, 1);
+            g->dataMalloc();
+            i->setData(IncrementalGenerator());
+            return std::make_pair(g, op->getOutput());
+        };
+
+        auto [sequential, expected] = build();
+        runtime->run(sequential);
+
+        runtime->setNumThreads(4);
+        runtime->setInterOpParallel(true);
+        EXPECT_EQ(runtime->getNumThreads(), 4u);
+        for (int repeat = 0; repeat < 20; ++repeat)
+        {
+            auto [parallel, output] = build();
+            runtime->run(parallel);
+            EXPECT_TRUE(output->equalData(expected));
+        }
+        runtime->setNumThreads(1);
+        EXPECT_EQ(runtime->getNumThreads(), 1u);
+        EXPECT_THROW(runtime->setNumThreads(0), Exception);
+    }
+
+    TEST(Runtime, ExecutionPlan)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, 2.0f, 4.0f)->getOutput();
+        auto y = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{x, y}, nullptr, 0);
+        g->dataMalloc();
+
+        auto plan = runtime->compile(g);
+        EXPECT_EQ(plan.launches.size(), 3u);
+        i->setData(IncrementalGenerator());
+        runtime->run(plan);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{2, 2, 2, 3, 4, 4, 0, 1, 2, 3, 4, 5}));
+
+        // the plan reads the data the tensors hold when it runs
+        vector<float> data{-1, 5, -3, 7, -5, 9};
+        std::copy(data.begin(), data.end(), i->getRawDataPtr<float *>());
+        runtime->run(plan);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{2, 4, 2, 4, 2, 4, 0, 5, 0, 7, 0, 9}));
+
+        runtime->setNumThreads(2);
+        runtime->setInterOpParallel(true);
+        runtime->run(plan);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{2, 4, 2, 4, 2, 4, 0, 5, 0, 7, 0, 9}));
+    }
+
+    TEST(Runtime, Profiling)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, 2.0f, 4.0f)->getOutput();
+        auto y = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{x, y}, nullptr, 0);
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+
+        EXPECT_EQ(runtime->getProfiler(), nullptr);
+        runtime->setProfiling(true);
+        runtime->run(g);
+        runtime->run(g);
+        runtime->setProfiling(false);
+        // not recorded
+        runtime->run(g);
+
+        auto profiler = runtime->getProfiler();
+        auto records = profiler->getRecords();
+        ASSERT_EQ(records.size(), 6u);
+        EXPECT_EQ(records[2].guid, op->getGuid());
+        EXPECT_EQ(records[2].kernel, "ConcatNaive_CPU");
+        EXPECT_EQ(records[2].inputs, (vector<Shape>{{2, 3}, {2, 3}}));
+        EXPECT_EQ(records[2].outputs, (vector<Shape>{{4, 3}}));
+
+        auto byOpType = profiler->byOpType();
+        EXPECT_EQ(byOpType.size(), 3u);
+        EXPECT_EQ(byOpType["Clip"].calls, 2u);
+        EXPECT_EQ(profiler->byKernel()["reluNaive_CPU"].calls, 2u);
+
+        auto trace = profiler->toChromeTrace();
+        EXPECT_EQ(trace.rfind("{\"traceEvents\": [", 0), 0u);
+        EXPECT_NE(trace.find("\"name\": \"Clip_CPU\", \"cat\": \"Clip\""),
+                  string::npos);
+        EXPECT_NE(profiler->summary().find("ConcatNaive_CPU"), string::npos);
+
+        // enabling again starts over
+        runtime->setProfiling(true);
+        EXPECT_TRUE(runtime->getProfiler()->getRecords().empty());
+    }
+
+    TEST(Runtime, KernelTuning)
+    {
+        auto &registry = KernelRegistry::getInstance();
+        auto &records =
+            registry.getKernelItems(KernelAttrs{Device::CPU, OpType::Relu});
+        ASSERT_EQ(records.size(), 2u);
+        // the default kernel comes first, whatever the registration order
+        EXPECT_EQ(std::get<1>(records[0]), "reluNaive_CPU");
+        EXPECT_TRUE(registry.isInPlaceSafe(KernelAttrs{Device::CPU, OpType::Relu}));
+
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, -2.0f, 2.0f)->getOutput();
+        auto y = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto z = g->addOp<ReluObj>(y, nullptr)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{z, x}, nullptr, 0);
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+
+        // variants are ignored unless tuning
+        EXPECT_EQ(runtime->compile(g).kernels[1], "reluNaive_CPU");
+        EXPECT_EQ(runtime->getTunedKernelCount(), 0u);
+
+        runtime->setKernelTuning(true);
+        auto plan = runtime->compile(g);
+        EXPECT_EQ(plan.kernels[1], "reluNaive_CPU");
+        EXPECT_EQ(plan.kernels[2], "reluNaive_CPU");
+        // both relus have the same shapes, the other ops have one kernel
+        EXPECT_EQ(runtime->getTunedKernelCount(), 1u);
+        // tuning leaves the data alone
+        EXPECT_TRUE(i->equalData(vector<float>{0, 1, 2, 3, 4, 5}));
+        runtime->run(plan);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{0, 1, 2, 2, 2, 2, 0, 1, 2, 2, 2, 2}));
+
+        runtime->clearTunedKernels();
+        EXPECT_EQ(runtime->getTunedKernelCount(), 0u);
+
+        // ops of equal shapes but other attributes are tuned apart
+        auto clip = [&](std::optional<float> min, std::optional<float> max)
+        { return g->addOp<ClipObj>(i, nullptr, min, max)->getOpAttrVector(); };
+        EXPECT_EQ(clip(0.0f, 1.0f), clip(0.0f, 1.0f));
+        EXPECT_NE(clip(0.0f, 1.0f), clip(0.0f, 2.0f));
+        EXPECT_NE(clip(0.0f, std::nullopt), clip(0.0f, 0.0f));
+        Tensor s = g->addTensor({3, 3}, DataType::Float32);
+        EXPECT_NE(g->addOp<MatmulObj>(s, s, nullptr, true)->getOpAttrVector(),
+                  g->addOp<MatmulObj>(s, s, nullptr)->getOpAttrVector());
+        EXPECT_NE(g->addOp<TransposeObj>(s, nullptr, vector<int>{1, 0})
+                      ->getOpAttrVector(),
+                  g->addOp<TransposeObj>(s, nullptr, vector<int>{0, 1})
+                      ->getOpAttrVector());
+    }
+
+    TEST(Runtime, ParallelFor)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setNumThreads(4, true);
+        vector<std::atomic<int>> hits(1000);
+        runtime->parallelFor(
+            hits.size(),
+            [&](size_t begin, size_t end)
+            {
+                // nested calls run on idle workers or the caller
+                runtime->parallelFor(end - begin, [&](size_t b, size_t e)
+                                     {
+                                         for (size_t i = begin + b; i < begin + e; ++i)
+                                             ++hits[i];
+                                     });
+            },
+            10);
+        for (auto &hit : hits)
+            EXPECT_EQ(hit, 1);
+        EXPECT_THROW(runtime->parallelFor(100, [](size_t, size_t)
+                                          { IT_TODO_HALT(); }),
+                     Exception);
+
+        // kernels split large tensors
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({4, 100000}, DataType::Float32);
+        auto op = g->addOp<ClipObj>(i, nullptr, 0.0f, 1000.0f);
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        auto output = op->getOutput()->getRawDataPtr<float *>();
+        for (size_t k = 0; k < op->getOutput()->size(); k += 997)
+            EXPECT_EQ(output[k], std::min(float(k), 1000.0f));
+    }
+
+} // namespace infini
@@ -0,0 +1,69 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "core/stream.h"
+#include "operators/concat.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(Stream, Run)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto x = g->addOp<ClipObj>(i, nullptr, -2.0f, 2.0f)->getOutput();
+        auto y = g->addOp<ReluObj>(i, nullptr)->getOutput();
+        auto op = g->addOp<ConcatObj>(TensorVec{x, y}, nullptr, 1);
+        g->dataMalloc();
+
+        vector<vector<float>> data;
+        for (int r = 0; r < 7; ++r)
+        {
+            vector<float> input(6);
+            for (int j = 0; j < 6; ++j)
+                input[j] = float((j - 3) * (r + 1));
+            data.emplace_back(input);
+        }
+        vector<Stream::Request> requests;
+        for (auto &input : data)
+            requests.push_back({input.data()});
+
+        for (size_t depth : {1, 2, 3})
+        {
+            Stream stream(g, depth);
+            EXPECT_EQ(stream.getDepth(), depth);
+            size_t calls = 0;
+            stream.run(requests,
+                       [&](size_t idx, const vector<const void *> &outputs)
+                       {
+                           EXPECT_EQ(idx, calls++);
+                           ASSERT_EQ(outputs.size(), 1u);
+                           auto out = static_cast<const float *>(outputs[0]);
+                           auto &in = data[idx];
+                           for (int r = 0; r < 2; ++r)
+                               for (int c = 0; c < 3; ++c)
+                               {
+                                   float v = in[r * 3 + c];
+                                   EXPECT_EQ(out[r * 6 + c],
+                                             std::min(std::max(v, -2.0f), 2.0f));
+                                   EXPECT_EQ(out[r * 6 + 3 + c],
+                                             std::max(v, 0.0f));
+                               }
+                       });
+            EXPECT_EQ(calls, requests.size());
+        }
+
+        // the graph runs on its own memory again
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{0, 1, 2, 0, 1, 2, 2, 2, 2, 3, 4, 5}));
+
+        Stream stream(g);
+        EXPECT_THROW(stream.run({{}}, [](size_t, const vector<const void *> &) {}),
+                     Exception);
+    }
+
+} // namespace infini
@@ -25,4 +25,48 @@ TEST(Concat, NativeCpu) {
                       6, 7, 8, 1, 1, 1, 9, 10, 11, 1, 1, 1}));
 }
 
+TEST(Concat, NativeCpuAxes) {
+    // the outermost, a middle and the innermost axis, split into chunks that
+    // start in the middle of runs, and runs shorter than a copy call
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    runtime->setNumThreads(3);
+    for (auto [dim, sizes] : vector<pair<int, vector<int>>>{
+             {0, {3, 1, 70, 5}},
+             {1, {3, 1, 70, 5}},
+             {2, {3, 1, 70, 5}},
+             {2, {3, 1, 4}}}) {
+        Graph g = make_ref<GraphObj>(runtime);
+        TensorVec inputs;
+        for (int size : sizes) {
+            Shape shape{60, 50, 40};
+            shape[dim] = size;
+            inputs.push_back(g->addTensor(shape, DataType::UInt32));
+        }
+        auto op = g->addOp<ConcatObj>(inputs, nullptr, dim);
+        g->dataMalloc();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto ptr = inputs[i]->getRawDataPtr<uint32_t *>();
+            for (size_t j = 0; j < inputs[i]->size(); ++j)
+                ptr[j] = i << 24 | j;
+        }
+        runtime->run(g);
+
+        // walk the output and the position of each element in its input
+        auto outDim = op->getOutput()->getDims();
+        vector<uint32_t> expected;
+        for (int a = 0; a < outDim[0]; ++a)
+            for (int b = 0; b < outDim[1]; ++b)
+                for (int c = 0; c < outDim[2]; ++c) {
+                    int pos[3] = {a, b, c};
+                    size_t i = 0;
+                    while (pos[dim] >= inputs[i]->getDims()[dim])
+                        pos[dim] -= inputs[i++]->getDims()[dim];
+                    auto inDim = inputs[i]->getDims();
+                    size_t j = (pos[0] * inDim[1] + pos[1]) * inDim[2] + pos[2];
+                    expected.push_back(i << 24 | j);
+                }
+        EXPECT_TRUE(op->getOutput()->equalData(expected)) << "dim " << dim;
+    }
+}
+
 } // namespace infini
@@ -41,4 +41,50 @@ TEST(ElementWise, NativeCpu) {
         Shape{2, 1, 1}, ExpectOutput{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
 }
 
+TEST(ElementWise, NativeCpuBroadcastPatterns) {
+    // identical, scalar, row, column and mixed broadcasts, large enough to be
+    // split into chunks that start in the middle of rows
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    runtime->setNumThreads(3);
+    for (auto [shapeA, shapeB] : vector<std::pair<Shape, Shape>>{
+             {{300, 257}, {300, 257}},
+             {{300, 257}, {}},
+             {{}, {300, 257}},
+             {{300, 257}, {257}},
+             {{300, 257}, {300, 1}},
+             {{300, 1}, {1, 257}},
+             {{6, 1, 50, 257}, {7, 1, 1}},
+             // alternating broadcasts left at rank 9 after merging
+             {{2, 1, 2, 1, 2, 1, 2, 1, 37}, {1, 2, 1, 2, 1, 2, 1, 2, 37}}}) {
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor(shapeA, DataType::UInt32);
+        auto b = g->addTensor(shapeB, DataType::UInt32);
+        auto op = g->addOp<SubObj>(a, b, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        runtime->run(g);
+
+        auto shapeC = op->getOutput()->getDims();
+        auto rank = shapeC.size();
+        shapeA.insert(shapeA.begin(), rank - shapeA.size(), 1);
+        shapeB.insert(shapeB.begin(), rank - shapeB.size(), 1);
+        vector<uint32_t> expected(op->getOutput()->size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            size_t rest = i, indexA = 0, indexB = 0, pA = 1, pB = 1;
+            for (size_t d = rank; d > 0; --d) {
+                size_t pos = rest % shapeC[d - 1];
+                rest /= shapeC[d - 1];
+                indexA += (shapeA[d - 1] == 1 ? 0 : pos) * pA;
+                indexB += (shapeB[d - 1] == 1 ? 0 : pos) * pB;
+                pA *= shapeA[d - 1];
+                pB *= shapeB[d - 1];
+            }
+            expected[i] = uint32_t(indexA) - uint32_t(indexB);
+        }
+        EXPECT_TRUE(op->getOutput()->equalData(expected))
+            << vecToString(shapeA) << " - " << vecToString(shapeB);
+    }
+}
+
 } // namespace infini
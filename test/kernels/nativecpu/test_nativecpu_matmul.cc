@@ -0,0 +1,92 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Computes C = op(A) x op(B) on every batch, broadcasting the batches of B
+static vector<float> matmulReference(const vector<float> &a,
+                                     const vector<float> &b, size_t batch,
+                                     bool broadcastB, size_t m, size_t n,
+                                     size_t k, bool transA, bool transB) {
+    vector<float> c(batch * m * n);
+    for (size_t t = 0; t < batch; ++t) {
+        auto pa = a.data() + t * m * k;
+        auto pb = b.data() + (broadcastB ? 0 : t * k * n);
+        for (size_t i = 0; i < m; ++i)
+            for (size_t j = 0; j < n; ++j) {
+                float sum = 0;
+                for (size_t p = 0; p < k; ++p)
+                    sum += (transA ? pa[p * m + i] : pa[i * k + p]) *
+                           (transB ? pb[j * k + p] : pb[p * n + j]);
+                c[(t * m + i) * n + j] = sum;
+            }
+    }
+    return c;
+}
+
+static void testMatmul(size_t batch, bool broadcastB, size_t m, size_t n,
+                       size_t k, bool transA, bool transB) {
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    runtime->setNumThreads(2);
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor(transA ? Shape{int(batch), int(k), int(m)}
+                                 : Shape{int(batch), int(m), int(k)},
+                          DataType::Float32);
+    auto B = g->addTensor(Shape{broadcastB ? 1 : int(batch),
+                                int(transB ? n : k), int(transB ? k : n)},
+                          DataType::Float32);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr, transA, transB);
+    g->dataMalloc();
+
+    // small integers keep the float sums exact
+    vector<float> a(A->size()), b(B->size());
+    for (size_t i = 0; i < a.size(); ++i)
+        a[i] = float(i % 7) - 3;
+    for (size_t i = 0; i < b.size(); ++i)
+        b[i] = float(i % 5) - 2;
+    std::copy(a.begin(), a.end(), A->getRawDataPtr<float *>());
+    std::copy(b.begin(), b.end(), B->getRawDataPtr<float *>());
+
+    runtime->run(g);
+    EXPECT_EQ(op->getOutput()->getDims(),
+              (Shape{int(batch), int(m), int(n)}));
+    EXPECT_TRUE(op->getOutput()->equalData(
+        matmulReference(a, b, batch, broadcastB, m, n, k, transA, transB)));
+}
+
+TEST(Matmul, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+
+    auto A = g->addTensor({1, 2, 3}, DataType::Float32);
+    auto B = g->addTensor({1, 3, 2}, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr);
+    g->dataMalloc();
+    A->setData(IncrementalGenerator());
+    B->setData(IncrementalGenerator());
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(vector<float>{10, 13, 28, 40}));
+}
+
+TEST(Matmul, NativeCpuTranspose) {
+    for (bool transA : {false, true})
+        for (bool transB : {false, true})
+            testMatmul(1, false, 37, 21, 19, transA, transB);
+}
+
+TEST(Matmul, NativeCpuBlocked) {
+    // crosses the cache blocks in every dimension, with partial blocks
+    testMatmul(1, false, 130, 300, 270, false, false);
+    testMatmul(1, false, 130, 300, 270, true, true);
+}
+
+TEST(Matmul, NativeCpuBatchBroadcast) {
+    testMatmul(3, false, 5, 7, 9, false, true);
+    testMatmul(3, true, 5, 7, 9, true, false);
+}
+
+} // namespace infini
@@ -0,0 +1,140 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+#include "utils/simd.h"
+
+#include "test.h"
+#include <cmath>
+#include <cstring>
+
+namespace infini {
+
+// Runs the op built by `build` on data from `fill` with every instruction set
+// the machine supports, and expects the output of the portable loops.
+template <typename T>
+static void testAllIsas(
+    const std::function<Operator(const Graph &, DataType)> &build,
+    const std::function<T(size_t)> &fill) {
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    auto dtype =
+        std::is_same_v<T, float> ? DataType::Float32 : DataType::UInt32;
+    auto detected = detectCpuIsa();
+    vector<T> expected;
+    for (auto isa : {CpuIsa::Generic, CpuIsa::AVX2, CpuIsa::AVX512}) {
+        if (isa > detected)
+            break;
+        setCpuIsa(isa);
+        Graph g = make_ref<GraphObj>(runtime);
+        Operator op = build(g, dtype);
+        g->dataMalloc();
+        for (const Tensor &input : op->getInputs()) {
+            auto ptr = input->getRawDataPtr<T *>();
+            for (size_t i = 0; i < input->size(); ++i)
+                ptr[i] = fill(i);
+        }
+        runtime->run(g);
+
+        Tensor output = op->getOutput();
+        auto ptr = output->getRawDataPtr<T *>();
+        if (isa == CpuIsa::Generic)
+            expected.assign(ptr, ptr + output->size());
+        else
+            EXPECT_EQ(memcmp(expected.data(), ptr, output->getBytes()), 0)
+                << op->toString() << " on " << toString(isa);
+    }
+    setCpuIsa(detected);
+}
+
+static float floatData(size_t i) {
+    const float special[] = {0.f, -0.f, NAN, INFINITY, -INFINITY};
+    return i % 17 < 5 ? special[i % 17] : float(int(i % 23) - 11) / 3;
+}
+
+static uint32_t uintData(size_t i) { return uint32_t(i * 2654435761u) >> 12; }
+
+template <typename T>
+static void testBinary(const std::function<T(size_t)> &fill) {
+    // a tail shorter than a register, and the scalar operands of broadcasts
+    for (auto [shapeA, shapeB] :
+         vector<pair<Shape, Shape>>{{{3, 37}, {3, 37}},
+                                    {{3, 37}, {1}},
+                                    {{1}, {3, 37}},
+                                    {{3, 37}, {3, 1}}}) {
+        auto build = [shapeA = shapeA, shapeB = shapeB](
+                         OpType type) -> std::function<Operator(
+                                          const Graph &, DataType)> {
+            return [=](const Graph &g, DataType dtype) -> Operator {
+                auto a = g->addTensor(shapeA, dtype);
+                auto b = g->addTensor(shapeB, dtype);
+                switch (type.underlying()) {
+                case OpType::Add:
+                    return g->addOp<AddObj>(a, b, nullptr);
+                case OpType::Sub:
+                    return g->addOp<SubObj>(a, b, nullptr);
+                case OpType::Mul:
+                    return g->addOp<MulObj>(a, b, nullptr);
+                default:
+                    return g->addOp<DivObj>(a, b, nullptr);
+                }
+            };
+        };
+        testAllIsas<T>(build(OpType::Add), fill);
+        testAllIsas<T>(build(OpType::Sub), fill);
+        testAllIsas<T>(build(OpType::Mul), fill);
+        if constexpr (std::is_floating_point_v<T>)
+            testAllIsas<T>(build(OpType::Div), fill);
+    }
+}
+
+// Runs first: no other test of this program has dispatched to an instruction
+// set yet
+TEST(Simd, GenericBuildsNoTables) {
+    auto detected = detectCpuIsa();
+    setCpuIsa(CpuIsa::Generic);
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor({3, 37}, DataType::Float32);
+    auto b = g->addTensor({3, 37}, DataType::Float32);
+    auto sum = g->addOp<AddObj>(a, b, nullptr)->getOutput();
+    auto relu = g->addOp<ReluObj>(sum, nullptr)->getOutput();
+    auto op = g->addOp<ClipObj>(relu, nullptr, 0.0f, 50.0f);
+    g->dataMalloc();
+    a->setData(IncrementalGenerator());
+    b->setData(OneGenerator());
+    runtime->run(g);
+    vector<float> expected(3 * 37);
+    for (size_t i = 0; i < expected.size(); ++i)
+        expected[i] = std::min(float(i + 1), 50.0f);
+    EXPECT_TRUE(op->getOutput()->equalData(expected));
+    EXPECT_FALSE(isSimdTableBuilt(CpuIsa::AVX2));
+    EXPECT_FALSE(isSimdTableBuilt(CpuIsa::AVX512));
+    setCpuIsa(detected);
+}
+
+TEST(Simd, ElementWise) {
+    testBinary<float>(floatData);
+    testBinary<uint32_t>(uintData);
+}
+
+TEST(Simd, Relu) {
+    testAllIsas<float>(
+        [](const Graph &g, DataType dtype) {
+            return g->addOp<ReluObj>(g->addTensor({5, 41}, dtype), nullptr);
+        },
+        floatData);
+}
+
+TEST(Simd, Clip) {
+    for (auto [min, max] : vector<pair<optional<float>, optional<float>>>{
+             {1.f, 1000.f}, {std::nullopt, 3.f}, {5.f, std::nullopt}}) {
+        auto build = [min = min, max = max](const Graph &g, DataType dtype) {
+            return g->addOp<ClipObj>(g->addTensor({5, 41}, dtype), nullptr,
+                                     min, max);
+        };
+        testAllIsas<float>(build, floatData);
+        testAllIsas<uint32_t>(build, uintData);
+    }
+}
+
+} // namespace infini
@@ -2,6 +2,7 @@
 #include "core/kernel.h"
 #include "core/runtime.h"
 #include "operators/transpose.h"
+#include "utils/simd.h"
 
 #include "test.h"
 
@@ -24,4 +25,52 @@ TEST(Transpose, NativeCpu) {
                                                           8, 9, 10, 11, 20, 21, 22, 23}));
 }
 
+TEST(Transpose, NativeCpuPermutations) {
+    // 2D with partial tiles, swaps of the last two axes, rows moving whole,
+    // dimensions of size 1 and the identity, with portable and vectorized
+    // tiles
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    runtime->setNumThreads(2);
+    for (auto isa : {CpuIsa::Generic, detectCpuIsa()}) {
+        for (auto [shape, permute] : vector<pair<Shape, vector<int>>>{
+                 {{37, 45}, {1, 0}},
+                 {{256, 300}, {1, 0}},
+                 {{3, 20, 17}, {0, 2, 1}},
+                 {{4, 5, 6, 7}, {2, 0, 3, 1}},
+                 {{4, 5, 6, 7}, {1, 0, 2, 3}},
+                 {{2, 1, 9, 1, 10}, {4, 1, 3, 2, 0}},
+                 {{6, 1, 7}, {1, 0, 2}},
+                 {{3, 4}, {}}}) {
+            setCpuIsa(isa);
+            Graph g = make_ref<GraphObj>(runtime);
+            auto input = g->addTensor(shape, DataType::UInt32);
+            auto op = g->addOp<TransposeObj>(input, nullptr, permute);
+            g->dataMalloc();
+            input->setData(IncrementalGenerator());
+            runtime->run(g);
+
+            auto perm = op->getPermute();
+            auto outShape = op->getOutput()->getDims();
+            vector<uint32_t> expected(input->size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                // position of output element i in the input
+                size_t rest = i;
+                Shape pos(shape.size());
+                for (size_t d = shape.size(); d > 0; --d) {
+                    pos[perm[d - 1]] = rest % outShape[d - 1];
+                    rest /= outShape[d - 1];
+                }
+                size_t inIdx = 0;
+                for (size_t d = 0; d < shape.size(); ++d)
+                    inIdx = inIdx * shape[d] + pos[d];
+                expected[i] = inIdx;
+            }
+            EXPECT_TRUE(op->getOutput()->equalData(expected))
+                << vecToString(shape) << " " << vecToString(perm) << " on "
+                << toString(isa);
+        }
+    }
+    setCpuIsa(detectCpuIsa());
+}
+
 } // namespace infini